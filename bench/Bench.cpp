@@ -0,0 +1,141 @@
+#include "Bench.hpp"
+
+#include <cstdlib> // EXIT_SUCCESS, EXIT_FAILURE
+#include <filesystem> // temp_directory_path, remove
+#include <fstream> // ofstream
+#include <iostream> // cout, cerr
+#include <ostream> // ostream
+#include <memory> // make_shared
+#include <random> // mt19937, uniform_int_distribution
+#include <string> // string
+#include <vector> // vector
+
+std::vector<Benchmark>& benchmarks() {
+    static std::vector<Benchmark> registry;
+    return registry;
+}
+
+namespace {
+    std::vector<BenchResult>& results() {
+        static std::vector<BenchResult> recorded;
+        return recorded;
+    }
+
+    std::size_t failures = 0;
+
+    // Names are ours and never need escaping
+    void writeJson(std::ostream& out) {
+        out << "{\n  \"results\": [";
+        bool first = true;
+        for (auto& result : results()) {
+            out << (first ? "\n" : ",\n")
+                << "    {\"benchmark\": \"" << result.benchmark << "\", \"operation\": \"" << result.operation
+                << "\", \"size\": " << result.size
+                << ", \"median_us\": " << result.latency.median_us
+                << ", \"p99_us\": " << result.latency.p99_us
+                << ", \"ops_per_sec\": " << result.latency.ops_per_sec << "}";
+            first = false;
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+void record(BenchResult result) {
+    results().push_back(std::move(result));
+}
+
+void fail(const std::string& what) {
+    std::cerr << "FAILED: " << what << '\n';
+    ++failures;
+}
+
+BookStack syntheticBooks(std::size_t n, unsigned seed) {
+    static const std::vector<std::string> words{
+        "the", "of", "night", "river", "empire", "silent", "garden", "machine", "history", "shadow",
+        "winter", "code", "stone", "light", "house", "war", "memory", "ocean", "city", "secret"
+    };
+    static const std::vector<std::string> names{
+        "Austen", "Tolstoy", "Achebe", "Morrison", "Borges", "Woolf", "Murakami", "Adichie",
+        "Orwell", "Le Guin", "Calvino", "Mahfouz", "Eco", "Atwood", "Rushdie", "Gebreyesus"
+    };
+
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<std::size_t> word(0, words.size() - 1);
+    std::uniform_int_distribution<std::size_t> name(0, names.size() - 1);
+    std::uniform_int_distribution<int> title_length(2, 6);
+
+    BookStack books;
+    books.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto book = std::make_shared<Book>();
+        book->book_id = i + 1;
+        for (int w = title_length(rng); w > 0; --w) {
+            book->title += (book->title.empty() ? "" : " ") + words[word(rng)];
+        }
+        book->author = names[name(rng)] + " " + names[name(rng)];
+        book->quantity = static_cast<int>(i % 7);
+        book->publisher = names[name(rng)] + " Press";
+        book->pub_year = 1900 + static_cast<int>(i % 124);
+        book->edition = 1 + static_cast<int>(i % 3);
+        book->rating = static_cast<double>(i % 50) / 10.0;
+        books.push_back(std::move(book));
+    }
+    return books;
+}
+
+ScratchDatabase::ScratchDatabase(const std::string& name)
+    : file((std::filesystem::temp_directory_path() / ("library_bench_" + name + ".db")).string()) {
+    remove();
+    std::ofstream{file};
+}
+
+ScratchDatabase::~ScratchDatabase() {
+    remove();
+}
+
+void ScratchDatabase::remove() {
+    for (auto suffix : {"", "-journal", "-wal", "-shm"}) {
+        std::filesystem::remove(file + suffix);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> filters;
+    std::string json_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            if (i + 1 == argc) {
+                std::cerr << "Usage: library_bench [--json FILE] [NAME_FILTER...]\n";
+                return EXIT_FAILURE;
+            }
+            json_path = argv[++i];
+        }
+        else {
+            filters.push_back(arg);
+        }
+    }
+
+    for (auto& benchmark : benchmarks()) {
+        bool selected = filters.empty();
+        for (auto& filter : filters) {
+            selected = selected || benchmark.name.find(filter) != std::string::npos;
+        }
+        if (not selected)
+            continue;
+
+        std::cout << "== " << benchmark.name << '\n';
+        benchmark.run();
+    }
+
+    if (not json_path.empty()) {
+        std::ofstream out{json_path};
+        writeJson(out);
+        if (not out) {
+            std::cerr << "Can't write " << json_path << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
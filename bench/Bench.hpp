@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Book.hpp"
+
+#include <algorithm> // sort
+#include <chrono> // steady_clock
+#include <cstddef> // size_t
+#include <functional> // function
+#include <string> // string
+#include <vector> // vector
+
+// A named benchmark, run by library_bench when its name matches the filter
+struct Benchmark {
+    std::string name;
+    std::function<void()> run;
+};
+
+std::vector<Benchmark>& benchmarks();
+
+// Registers a benchmark during static initialization
+struct RegisterBenchmark {
+    RegisterBenchmark(std::string name, std::function<void()> run) {
+        benchmarks().push_back({std::move(name), std::move(run)});
+    }
+};
+
+// Latency distribution of one operation, from per-call samples
+struct Latency {
+    double median_us;
+    double p99_us;
+    double ops_per_sec;
+};
+
+// Distribution of per-call samples, in microseconds. There must be at least one
+inline Latency summarize(std::vector<double> samples_us) {
+    double total = 0;
+    for (auto sample : samples_us) {
+        total += sample;
+    }
+    std::sort(samples_us.begin(), samples_us.end());
+    return {samples_us[samples_us.size() / 2], samples_us[samples_us.size() * 99 / 100], samples_us.size() / (total / 1e6)};
+}
+
+// Times reps calls of fn one by one
+template<class Fn>
+Latency measureLatency(Fn&& fn, int reps) {
+    std::vector<double> samples;
+    samples.reserve(reps);
+    for (int i = 0; i < reps; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    return summarize(std::move(samples));
+}
+
+// Times reps calls of fn one by one, each after a call of setup that is not timed
+template<class Setup, class Fn>
+Latency measureLatency(Setup&& setup, Fn&& fn, int reps) {
+    std::vector<double> samples;
+    samples.reserve(reps);
+    for (int i = 0; i < reps; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    return summarize(std::move(samples));
+}
+
+// One measurement, as written to the file given with --json
+struct BenchResult {
+    std::string benchmark;
+    std::string operation;
+    std::size_t size; // books in the catalog, 0 where that doesn't apply
+    Latency latency;
+};
+
+// Keeps a result for --json. Printing it for people is up to the benchmark
+void record(BenchResult result);
+
+// For benchmarks that also check what they measure: reports what went wrong,
+// and library_bench exits with a failure status once every benchmark has run
+void fail(const std::string& what);
+
+// Deterministic catalog of n books with realistic title and author lengths
+BookStack syntheticBooks(std::size_t n, unsigned seed = 42);
+
+// An empty database file in the temp directory, removed together with its
+// journal and WAL when the benchmark is done with it
+class ScratchDatabase {
+    public:
+        explicit ScratchDatabase(const std::string& name);
+        ~ScratchDatabase();
+        ScratchDatabase(const ScratchDatabase&) = delete;
+        ScratchDatabase& operator=(const ScratchDatabase&) = delete;
+
+        const std::string& path() const { return file; }
+
+    private:
+        void remove();
+        std::string file;
+};
+
+// Catalog sizes every size-dependent benchmark is run at
+inline const std::vector<std::size_t> catalog_sizes{1'000, 10'000, 50'000, 100'000};
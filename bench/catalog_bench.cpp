@@ -0,0 +1,82 @@
+#include "Bench.hpp"
+#include "BookCatalog.hpp"
+#include "SearchMatcher.hpp"
+
+#include <algorithm> // sort
+#include <cstddef> // size_t
+#include <cstdio> // printf
+
+namespace {
+    // Books a search for text would show, over today's vector of shared_ptr
+    std::size_t scanStack(const BookStack& books, const SearchMatcher& matcher) {
+        std::size_t found = 0;
+        for (auto& book : books) {
+            found += matcher.matches(book->title) || matcher.matches(book->author);
+        }
+        return found;
+    }
+
+    std::size_t scanCatalog(const BookCatalog& catalog, const SearchMatcher& matcher) {
+        auto& titles = catalog.titleColumn();
+        auto& authors = catalog.authorColumn();
+        auto& strings = catalog.internedStrings();
+        std::size_t found = 0;
+        for (std::size_t slot = 0; slot < catalog.size(); ++slot) {
+            found += matcher.matches(titles[slot]) || matcher.matches(strings[authors[slot]]);
+        }
+        return found;
+    }
+
+    long availableStack(const BookStack& books) {
+        long total = 0;
+        for (auto& book : books) {
+            total += book->quantity;
+        }
+        return total;
+    }
+
+    long availableCatalog(const BookCatalog& catalog) {
+        long total = 0;
+        for (auto quantity : catalog.quantityColumn()) {
+            total += quantity;
+        }
+        return total;
+    }
+
+    void sortStack(BookStack& books) {
+        std::stable_sort(books.begin(), books.end(), [](const BookPtr& a, const BookPtr& b) {
+            return a->rating > b->rating;
+        });
+    }
+
+    void layout() {
+        SearchMatcher matcher{"river"};
+        std::printf("%-10s %-16s %12s %12s %9s\n", "books", "operation", "stack us", "catalog us", "speedup");
+        for (auto n : catalog_sizes) {
+            auto books = syntheticBooks(n);
+            BookCatalog catalog{books};
+            BookStack unsorted;
+            volatile long sink = 0;
+
+            auto row = [n](const std::string& operation, Latency stack, Latency columns) {
+                std::printf("%-10zu %-16s %12.1f %12.1f %8.1fx\n", n, operation.c_str(),
+                            stack.median_us, columns.median_us, stack.median_us / columns.median_us);
+                record({"catalog/layout", operation + " (stack)", n, stack});
+                record({"catalog/layout", operation + " (catalog)", n, columns});
+            };
+
+            row("search scan",
+                measureLatency([&] { sink = scanStack(books, matcher); }, 15),
+                measureLatency([&] { sink = scanCatalog(catalog, matcher); }, 15));
+            row("quantity sum",
+                measureLatency([&] { sink = availableStack(books); }, 31),
+                measureLatency([&] { sink = availableCatalog(catalog); }, 31));
+            row("sort by rating",
+                // Each sample sorts a fresh copy, made before its clock starts
+                measureLatency([&] { unsorted = books; }, [&] { sortStack(unsorted); }, 7),
+                measureLatency([&] { sink = catalog.slotsByRating().size(); }, 7));
+        }
+    }
+
+    RegisterBenchmark catalog_layout{"catalog/layout", layout};
+}
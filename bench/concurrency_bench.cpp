@@ -0,0 +1,131 @@
+#include "Bench.hpp"
+#include "Durability.hpp"
+#include "Librarydb.hpp"
+#include "User.hpp"
+
+#include "SQLiteCpp/Exception.h"
+
+#include <algorithm> // find
+#include <atomic> // atomic
+#include <chrono> // steady_clock, seconds
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <memory> // make_shared
+#include <random> // mt19937, uniform_int_distribution
+#include <string> // string, to_string
+#include <thread> // thread
+#include <vector> // vector
+
+namespace {
+    constexpr std::size_t book_count = 200;
+    constexpr int copies = 3;
+    constexpr int writer_threads = 4;
+    constexpr int reader_threads = 8;
+    constexpr auto duration = std::chrono::seconds(2);
+
+    // Writers borrow and return books while readers query them, all on one
+    // shared Librarydb. Every copy must be accounted for at the end: on the
+    // shelf or borrowed, and no call may fail; otherwise the run fails. The
+    // library_stress target runs it under ThreadSanitizer, which fails it on a race.
+    void stress() {
+        std::printf("%-14s %12s %12s %10s %10s %s\n", "profile", "writes/s", "reads/s", "refused", "errors", "consistent");
+        for (auto& profile : durabilityProfiles()) {
+            ScratchDatabase scratch{"stress_" + profile.name};
+            Librarydb library{scratch.path(), profile};
+
+            auto import = library.importBooks(book_count);
+            for (auto& book : syntheticBooks(book_count)) {
+                book->quantity = copies;
+                import.add(*book, true);
+            }
+            import.finish();
+            for (int w = 0; w < writer_threads; ++w) {
+                auto name = "writer" + std::to_string(w);
+                library.addUser(std::make_shared<User>(User{name + "@library.me", name, UserClass::NORMAL}), name);
+            }
+
+            std::atomic<bool> stop = false;
+            std::atomic<std::size_t> writes = 0, reads = 0, refused = 0, errors = 0;
+            std::vector<std::thread> threads;
+
+            for (int w = 0; w < writer_threads; ++w) {
+                threads.emplace_back([&, w] {
+                    auto name = "writer" + std::to_string(w);
+                    std::mt19937 rng(w);
+                    std::uniform_int_distribution<std::size_t> book(1, book_count);
+                    while (not stop) {
+                        auto book_id = book(rng);
+                        try {
+                            // Returns whatever was borrowed, borrows whatever wasn't
+                            auto borrowed = library.getBorrowedIds(name);
+                            if (std::find(borrowed.begin(), borrowed.end(), book_id) != borrowed.end()) {
+                                library.unborrow(name, book_id);
+                            }
+                            else if (library.borrow(name, book_id) != BorrowResult::OK) {
+                                // Out of copies
+                                refused++;
+                                continue;
+                            }
+                            library.addFavourite(name, book_id);
+                            library.removeFavourite(name, book_id);
+                            writes += 3;
+                        }
+                        catch(const SQLite::Exception&) {
+                            errors++;
+                        }
+                    }
+                });
+            }
+            for (int r = 0; r < reader_threads; ++r) {
+                threads.emplace_back([&, r] {
+                    std::mt19937 rng(100 + r);
+                    std::uniform_int_distribution<std::size_t> book(1, book_count);
+                    while (not stop) {
+                        try {
+                            auto found = library.getBook(book(rng));
+                            if (not found || found->quantity < 0 || found->quantity > copies)
+                                errors++;
+                            library.getBooksPage(book(rng), 20);
+                            library.authenticate("writer0", "writer0");
+                            reads += 3;
+                        }
+                        catch(const SQLite::Exception&) {
+                            errors++;
+                        }
+                    }
+                });
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(duration);
+            stop = true;
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::vector<int> on_loan(book_count + 1);
+            for (int w = 0; w < writer_threads; ++w) {
+                for (auto book_id : library.getBorrowedIds("writer" + std::to_string(w))) {
+                    ++on_loan[book_id];
+                }
+            }
+            bool consistent = true;
+            for (auto& book : library.getAllBooks()) {
+                consistent = consistent && book->quantity + on_loan[book->book_id] == copies;
+            }
+
+            std::printf("%-14s %12.0f %12.0f %10zu %10zu %s\n", profile.name.c_str(), writes / seconds, reads / seconds,
+                        refused.load(), errors.load(), consistent ? "yes" : "NO");
+            if (not consistent)
+                fail("concurrency/stress " + profile.name + ": copies on the shelf and on loan don't add up");
+            if (errors > 0)
+                fail("concurrency/stress " + profile.name + ": " + std::to_string(errors.load()) + " calls failed");
+            // Throughput only; individual calls aren't timed here
+            record({"concurrency/stress", profile.name + " writes", book_count, {0, 0, writes / seconds}});
+            record({"concurrency/stress", profile.name + " reads", book_count, {0, 0, reads / seconds}});
+        }
+    }
+
+    RegisterBenchmark concurrency_stress{"concurrency/stress", stress};
+}
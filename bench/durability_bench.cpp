@@ -0,0 +1,61 @@
+#include "Bench.hpp"
+#include "Durability.hpp"
+#include "Librarydb.hpp"
+#include "User.hpp"
+
+#include <algorithm> // ranges::max
+#include <chrono> // steady_clock
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <memory> // make_shared
+#include <utility> // pair
+#include <vector> // vector
+
+namespace {
+    constexpr std::size_t book_count = 1'000;
+    constexpr std::size_t round_trips = 500;
+
+    double elapsedMicros(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // Every borrow and unborrow is its own transaction, so each sample is the
+    // latency of one commit under the profile
+    void commitLatency() {
+        std::printf("%-14s %-10s %10s %10s %10s %12s\n", "profile", "operation", "p50 us", "p99 us", "max us", "commits/s");
+        for (auto& profile : durabilityProfiles()) {
+            ScratchDatabase scratch{profile.name};
+            Librarydb library{scratch.path(), profile};
+
+            auto reader = std::make_shared<User>(User{"reader@library.me", "reader", UserClass::NORMAL});
+            library.addUser(reader, "reader");
+            auto import = library.importBooks(book_count);
+            for (auto& book : syntheticBooks(book_count)) {
+                book->quantity = 1;
+                import.add(*book, true);
+            }
+            import.finish();
+
+            std::vector<double> borrows, returns;
+            for (std::size_t i = 0; i < round_trips; ++i) {
+                auto book_id = 1 + i % book_count;
+                auto start = std::chrono::steady_clock::now();
+                library.borrow(reader->username, book_id);
+                borrows.push_back(elapsedMicros(start));
+
+                start = std::chrono::steady_clock::now();
+                library.unborrow(reader->username, book_id);
+                returns.push_back(elapsedMicros(start));
+            }
+
+            for (auto [operation, samples] : {std::pair{"borrow", &borrows}, std::pair{"unborrow", &returns}}) {
+                auto latency = summarize(*samples);
+                std::printf("%-14s %-10s %10.1f %10.1f %10.1f %12.0f\n", profile.name.c_str(), operation,
+                            latency.median_us, latency.p99_us, std::ranges::max(*samples), latency.ops_per_sec);
+                record({"durability/commit", profile.name + " " + operation, book_count, latency});
+            }
+        }
+    }
+
+    RegisterBenchmark durability_commit{"durability/commit", commitLatency};
+}
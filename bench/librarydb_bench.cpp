@@ -0,0 +1,74 @@
+#include "App.hpp"
+#include "Bench.hpp"
+#include "Librarydb.hpp"
+#include "SearchMatcher.hpp"
+#include "User.hpp"
+
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <memory> // make_shared
+#include <random> // mt19937, uniform_int_distribution
+#include <string> // string, to_string
+
+namespace {
+    // Writes of one kind touch this many different books
+    constexpr int write_reps = 200;
+
+    void row(std::size_t n, const std::string& operation, Latency latency) {
+        std::printf("%-10zu %-22s %10.1f %10.1f %12.0f\n", n, operation.c_str(), latency.median_us, latency.p99_us, latency.ops_per_sec);
+        record({"librarydb/ops", operation, n, latency});
+    }
+
+    // The calls the screens make, against a database of n books opened the way
+    // the app opens it
+    void operations() {
+        std::printf("%-10s %-22s %10s %10s %12s\n", "books", "operation", "p50 us", "p99 us", "ops/s");
+        for (auto n : catalog_sizes) {
+            ScratchDatabase scratch{"ops_" + std::to_string(n)};
+            Librarydb library{scratch.path()};
+
+            auto books = syntheticBooks(n);
+            {
+                auto import = library.importBooks(n);
+                for (auto& book : books) {
+                    book->quantity = 1'000;
+                    import.add(*book, true);
+                }
+                import.finish();
+            }
+            auto reader = std::make_shared<User>(User{"reader@library.me", "reader", UserClass::NORMAL});
+            library.addUser(reader, "reader");
+
+            std::mt19937 rng{7};
+            std::uniform_int_distribution<std::size_t> any_book(1, n);
+            volatile std::size_t sink = 0;
+
+            row(n, "getAllBooks", measureLatency([&] { sink = library.getAllBooks().size(); }, n >= 50'000 ? 5 : 15));
+            row(n, "getBook", measureLatency([&] { sink = library.getBook(any_book(rng))->book_id; }, 2'000));
+            row(n, "authenticate", measureLatency([&] { sink = library.authenticate("reader", "reader") != nullptr; }, 2'000));
+
+            std::size_t next = 1;
+            row(n, "borrow", measureLatency([&] { library.borrow("reader", next++); }, write_reps));
+            next = 1;
+            row(n, "unborrow", measureLatency([&] { library.unborrow("reader", next++); }, write_reps));
+            next = 1;
+            row(n, "addFavourite", measureLatency([&] { library.addFavourite("reader", next++); }, write_reps));
+            for (std::size_t id = 1; id < next; ++id) {
+                library.removeFavourite("reader", id);
+            }
+            row(n, "rateBook", measureLatency([&] { library.rateBook("reader", any_book(rng), 4); }, write_reps));
+
+            // Every row of a book menu asks on every render
+            SearchMatcher matcher{"river"};
+            row(n, "isSearchResult frame", measureLatency([&] {
+                std::size_t shown = 0;
+                for (auto& book : books) {
+                    shown += App::isSearchResult(book, matcher);
+                }
+                sink = shown;
+            }, 21));
+        }
+    }
+
+    RegisterBenchmark librarydb_operations{"librarydb/ops", operations};
+}
@@ -0,0 +1,186 @@
+#include "Bench.hpp"
+#include "Durability.hpp"
+#include "Librarydb.hpp"
+
+#include "SQLiteCpp/Database.h"
+#include "SQLiteCpp/Statement.h"
+#include "SQLiteCpp/Transaction.h"
+
+#include <chrono> // steady_clock
+#include <cstddef> // size_t
+#include <cstdint> // int64_t
+#include <cstdio> // printf
+#include <random> // mt19937, uniform_int_distribution
+#include <string> // string, to_string
+#include <vector> // vector
+
+namespace {
+    // Relation rows per book, in each of borrows and favourites
+    constexpr std::size_t rows_per_book = 3;
+    constexpr std::size_t users = 10'000;
+    constexpr int reps = 50;
+
+    void row(std::size_t n, const std::string& operation, Latency latency) {
+        std::printf("%-10zu %-26s %10.1f %10.1f %12.0f\n", n, operation.c_str(), latency.median_us, latency.p99_us, latency.ops_per_sec);
+        record({"schema/relations", operation, n, latency});
+    }
+
+    // Queries that go through a relation table by book, and one by user for comparison
+    void measure(std::size_t n, const std::string& schema, SQLite::Database& databs, std::size_t& next_removed) {
+        std::mt19937 rng{11};
+        std::uniform_int_distribution<std::size_t> any_book(1, n);
+        std::uniform_int_distribution<std::size_t> any_user(0, users - 1);
+        volatile std::int64_t sink = 0;
+
+        SQLite::Statement readers(databs, "SELECT count(username) FROM [borrows] WHERE book_id = ?");
+        row(n, schema + " readers of book", measureLatency([&] {
+            readers.reset();
+            readers.bind(1, static_cast<std::int64_t>(any_book(rng)));
+            readers.executeStep();
+            sink = readers.getColumn(0).getInt64();
+        }, reps));
+
+        SQLite::Statement favourites(databs, R"#(
+            SELECT [books].[book_id], [title]
+                FROM [favourites] JOIN [books] ON favourites.book_id = books.book_id
+                WHERE favourites.username = ?
+        )#");
+        row(n, schema + " favourites of user", measureLatency([&] {
+            favourites.reset();
+            favourites.bind(1, "user" + std::to_string(any_user(rng)));
+            while (favourites.executeStep()) {
+                sink = favourites.getColumn(0).getInt64();
+            }
+        }, reps));
+
+        // Cascades to both relation tables, and the borrow trigger gives copies back
+        SQLite::Statement remove(databs, "DELETE FROM [books] WHERE book_id = ?");
+        row(n, schema + " removeBook", measureLatency([&] {
+            remove.reset();
+            remove.bind(1, static_cast<std::int64_t>(next_removed++));
+            remove.exec();
+        }, reps));
+    }
+
+    // Takes a database just made by Librarydb back to schema version 1, from
+    // before the relation tables were rebuilt and ratings were added: rowid
+    // relation tables keyed only by (username, book_id), as makeSchema() made
+    // them then, with the borrow triggers on them
+    void toVersion1(SQLite::Database& databs) {
+        databs.exec("DROP TABLE [ratings]");
+        databs.exec("ALTER TABLE [books] DROP COLUMN [rating_total]");
+        databs.exec("DROP TRIGGER [remove_admin_borrows]");
+        databs.exec("DROP TABLE [favourites]");
+        databs.exec("DROP TABLE [borrows]");
+        databs.exec(R"#(
+                 CREATE TABLE [favourites]
+                 (
+                    [username] VARCHAR(50) NOT NULL,
+                    [book_id] INTEGER NOT NULL,
+                    CONSTRAINT [pk_favourites] PRIMARY KEY (username, book_id),
+                    FOREIGN KEY ([username]) REFERENCES [users] (username)
+                        ON DELETE CASCADE,
+                    FOREIGN KEY (book_id) REFERENCES [books] (book_id)
+                        ON DELETE CASCADE
+                 )
+                 )#");
+        databs.exec(R"#(
+                 CREATE TABLE [borrows]
+                 (
+                    [username] VARCHAR(50) NOT NULL,
+                    [book_id] INTEGER NOT NULL,
+                    CONSTRAINT [pk_favourites] PRIMARY KEY (username, book_id),
+                    FOREIGN KEY (username) REFERENCES [users] (username)
+                        ON DELETE CASCADE,
+                    FOREIGN KEY (book_id) REFERENCES [books] (book_id)
+                        ON DELETE CASCADE
+                 )
+                 )#");
+        databs.exec(R"#(
+                CREATE TRIGGER decrease_book_number
+                     AFTER INSERT ON [borrows]
+                BEGIN
+                    UPDATE [books] SET quantity = quantity - 1
+                        WHERE book_id = NEW.book_id;
+                END
+                )#");
+        databs.exec(R"#(
+                CREATE TRIGGER increase_book_number
+                     AFTER DELETE ON [borrows]
+                BEGIN
+                    UPDATE [books] SET quantity = quantity + 1
+                        WHERE book_id = OLD.book_id;
+                END
+                )#");
+        databs.exec(R"#(
+                CREATE TRIGGER remove_admin_borrows
+                     AFTER UPDATE ON [users]
+                WHEN NEW.type = 'Admin' AND OLD.type = 'Regular'
+                BEGIN
+                     DELETE FROM [borrows]
+                        WHERE username = NEW.username;
+                END
+                )#");
+        databs.exec("PRAGMA user_version = 1");
+    }
+
+    // A catalog of n books with rows_per_book borrows and favourites each,
+    // measured first as it was before migrations and then after them
+    void relations() {
+        std::printf("%-10s %-26s %10s %10s %12s\n", "books", "operation", "p50 us", "p99 us", "ops/s");
+        for (std::size_t n : {10'000, 100'000}) {
+            ScratchDatabase scratch{"schema_" + std::to_string(n)};
+            {
+                Librarydb library{scratch.path(), durabilityProfile("wal-balanced")};
+                auto import = library.importBooks(n);
+                for (auto& book : syntheticBooks(n)) {
+                    book->quantity = 1'000;
+                    import.add(*book, true);
+                }
+                import.finish();
+            }
+
+            SQLite::Database databs(scratch.path(), SQLite::OPEN_READWRITE);
+            {
+                SQLite::Transaction trxn(databs);
+                toVersion1(databs);
+
+                SQLite::Statement user(databs, "INSERT INTO [users] (username, email, password) VALUES (?, ?, 'pw')");
+                for (std::size_t u = 0; u < users; ++u) {
+                    user.reset();
+                    user.bind(1, "user" + std::to_string(u));
+                    user.bind(2, "user" + std::to_string(u) + "@library.me");
+                    user.exec();
+                }
+
+                std::mt19937 rng{5};
+                std::uniform_int_distribution<std::size_t> any_user(0, users - 1);
+                for (auto table : {"borrows", "favourites"}) {
+                    SQLite::Statement pair(databs, std::string{"INSERT OR IGNORE INTO ["} + table + "] (username, book_id) VALUES (?, ?)");
+                    for (std::size_t book_id = 1; book_id <= n; ++book_id) {
+                        for (std::size_t r = 0; r < rows_per_book; ++r) {
+                            pair.reset();
+                            pair.bind(1, "user" + std::to_string(any_user(rng)));
+                            pair.bind(2, static_cast<std::int64_t>(book_id));
+                            pair.exec();
+                        }
+                    }
+                }
+                trxn.commit();
+            }
+            databs.exec("PRAGMA foreign_keys = ON");
+
+            std::size_t next_removed = 1;
+            measure(n, "before", databs, next_removed);
+
+            auto start = std::chrono::steady_clock::now();
+            { Librarydb migrated{scratch.path(), durabilityProfile("wal-balanced")}; }
+            auto took = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            row(n, "migrate", summarize({took}));
+
+            measure(n, "after", databs, next_removed);
+        }
+    }
+
+    RegisterBenchmark schema_relations{"schema/relations", relations};
+}
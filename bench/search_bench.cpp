@@ -0,0 +1,91 @@
+#include "Bench.hpp"
+#include "NarrowingFilter.hpp"
+#include "SearchMatcher.hpp"
+
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <regex> // regex, regex_match
+#include <string> // string
+#include <vector> // vector
+
+namespace {
+    // One frame of the book menu: every row's Maybe filter is evaluated once
+    std::size_t regexFrame(const BookStack& books, const std::string& searchString) {
+        std::size_t shown = 0;
+        for (auto& book : books) {
+            // What every row used to do, on every render
+            std::regex pattern {".*" + searchString + ".*", std::regex_constants::icase};
+            shown += std::regex_match(book->title, pattern) || std::regex_match(book->author, pattern);
+        }
+        return shown;
+    }
+
+    std::size_t matcherFrame(const BookStack& books, const SearchMatcher& matcher) {
+        std::size_t shown = 0;
+        for (auto& book : books) {
+            shown += matcher.matches(book->title) || matcher.matches(book->author);
+        }
+        return shown;
+    }
+
+    void searchFrame() {
+        const std::string query = "Rivers";
+        std::printf("%-10s %14s %14s %10s\n", "books", "regex us", "matcher us", "speedup");
+        for (auto n : catalog_sizes) {
+            auto books = syntheticBooks(n);
+            SearchMatcher matcher{query};
+            volatile std::size_t sink = 0;
+
+            auto regex = measureLatency([&] { sink = regexFrame(books, query); }, 3);
+            auto matched = measureLatency([&] { sink = matcherFrame(books, matcher); }, 21);
+            std::printf("%-10zu %14.1f %14.1f %9.0fx\n", n, regex.median_us, matched.median_us, regex.median_us / matched.median_us);
+            record({"search/frame", "regex", n, regex});
+            record({"search/frame", "matcher", n, matched});
+        }
+    }
+
+    RegisterBenchmark search_frame{"search/frame", searchFrame};
+
+    // A query typed one character at a time, the rows refiltered on every
+    // keystroke: from scratch, and narrowed from the previous keystroke's rows
+    void searchTyping() {
+        const std::string typed = "river empire";
+        std::printf("%-10s %16s %16s %10s\n", "books", "rescan us/key", "narrow us/key", "speedup");
+        for (auto n : catalog_sizes) {
+            auto books = syntheticBooks(n);
+            SearchMatcher matcher;
+            auto show = [&](const BookPtr& book) { return matcher.matches(book->title) || matcher.matches(book->author); };
+            std::vector<int> rows;
+
+            auto rescan = measureLatency([&] {
+                for (std::size_t length = 1; length <= typed.size(); ++length) {
+                    matcher.set(typed.substr(0, length));
+                    rows.clear();
+                    for (int i = 0; i < static_cast<int>(books.size()); ++i) {
+                        if (show(books[i]))
+                            rows.push_back(i);
+                    }
+                }
+            }, 5);
+            auto narrow = measureLatency([&] {
+                NarrowingFilter filter;
+                for (std::size_t length = 1; length <= typed.size(); ++length) {
+                    matcher.set(typed.substr(0, length));
+                    filter.apply(matcher.pattern(), books, show, rows);
+                }
+            }, 5);
+
+            // Per keystroke
+            for (auto* latency : {&rescan, &narrow}) {
+                latency->median_us /= typed.size();
+                latency->p99_us /= typed.size();
+                latency->ops_per_sec *= typed.size();
+            }
+            std::printf("%-10zu %16.1f %16.1f %9.1fx\n", n, rescan.median_us, narrow.median_us, rescan.median_us / narrow.median_us);
+            record({"search/typing", "rescan", n, rescan});
+            record({"search/typing", "narrow", n, narrow});
+        }
+    }
+
+    RegisterBenchmark search_typing{"search/typing", searchTyping};
+}
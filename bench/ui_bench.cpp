@@ -0,0 +1,152 @@
+#include "App.hpp"
+#include "Bench.hpp"
+#include "Librarydb.hpp"
+#include "User.hpp"
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/component/event.hpp"
+#include "ftxui/dom/node.hpp"
+#include "ftxui/screen/screen.hpp"
+
+#include <algorithm> // min, ranges::find
+#include <chrono> // steady_clock
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <cstdlib> // getenv
+#include <map> // map
+#include <memory> // make_shared, make_unique
+#include <stdexcept> // runtime_error
+#include <string> // string, to_string
+#include <utility> // pair
+#include <vector> // vector
+
+namespace {
+    // Size of the terminal the frames are drawn for
+    constexpr int frame_width = 160;
+    constexpr int frame_height = 50;
+
+    // Events of the script, each under the name it is reported by
+    using Script = std::vector<std::pair<std::string, ftxui::Event>>;
+
+    // What a reader does on the home screen: type into the search box and
+    // take it back out, scroll the book list, and switch between tabs
+    Script homeScript() {
+        using ftxui::Event;
+        Script script;
+        auto add = [&](const std::string& step, Event event, int times = 1) {
+            for (int i = 0; i < times; ++i) {
+                script.emplace_back(step, event);
+            }
+        };
+
+        // From the main menu into the search box of "All books"
+        add("focus", Event::ArrowRight);
+        for (int i = 0; i < 20; ++i) {
+            for (char c : std::string{"river"}) {
+                add("type", Event::Character(c));
+            }
+            add("erase", Event::Backspace, 5);
+        }
+
+        // Out of the search box, down the list
+        add("scroll", Event::ArrowDown, 100);
+        add("scroll", Event::PageDown, 20);
+        add("scroll", Event::PageUp, 20);
+
+        // Back to the main menu, then through Borrowed and Favourites and back
+        add("tab", Event::ArrowLeft);
+        for (int i = 0; i < 20; ++i) {
+            add("tab", Event::ArrowDown, 2);
+            add("tab", Event::ArrowUp, 2);
+        }
+        return script;
+    }
+
+    // Stands in for the terminal loop. Every event goes to the screen's root
+    // component, then the frame is rendered off-screen and turned into the text
+    // a terminal would be sent; the time for all of that is the event's sample.
+    std::map<std::string, std::vector<double>> runScript(const User& usr, const Script& script) {
+        std::map<std::string, std::vector<double>> samples;
+        ftxui::Screen frame(frame_width, frame_height);
+        auto draw = [&](ftxui::Component& root) {
+            frame.Clear();
+            ftxui::Render(frame, root->Render());
+            return frame.ToString().size();
+        };
+
+        App app;
+        app.driver = [&](ftxui::Component root) {
+            // Text sent to the terminal, summed so no frame can be left unbuilt
+            std::size_t sent = draw(root);
+            for (auto& [step, event] : script) {
+                auto start = std::chrono::steady_clock::now();
+                root->OnEvent(event);
+                sent += draw(root);
+                auto end = std::chrono::steady_clock::now();
+                samples[step].push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+            if (sent == 0)
+                throw std::runtime_error{"the home screen drew nothing"};
+        };
+        app.showHome(usr);
+        return samples;
+    }
+
+    void report(std::size_t n, const std::map<std::string, std::vector<double>>& samples) {
+        for (auto& [step, step_samples] : samples) {
+            auto latency = summarize(step_samples);
+            std::printf("%-10zu %-10s %8zu %10.1f %10.1f\n", n, step.c_str(), step_samples.size(), latency.median_us, latency.p99_us);
+            record({"ui/frames", step, n, latency});
+        }
+    }
+
+    // A reader with a few borrowed and liked books, over a catalog of n books
+    void syntheticHome(std::size_t n) {
+        ScratchDatabase scratch{"ui_" + std::to_string(n)};
+        db = std::make_unique<Librarydb>(scratch.path());
+        {
+            auto import = db->importBooks(n);
+            for (auto& book : syntheticBooks(n)) {
+                book->quantity = 10;
+                import.add(*book, true);
+            }
+            import.finish();
+        }
+        User reader{"reader@library.me", "reader", UserClass::NORMAL};
+        db->addUser(std::make_shared<User>(reader), "reader");
+        for (std::size_t book_id = 1; book_id <= std::min<std::size_t>(n, 20); ++book_id) {
+            db->borrow(reader.username, book_id);
+            db->addFavourite(reader.username, book_id);
+        }
+
+        report(n, runScript(reader, homeScript()));
+        db.reset();
+    }
+
+    // The home screen of a normal user, typed into, scrolled and tabbed through.
+    // LIBRARY_BENCH_DB and LIBRARY_BENCH_USER run it on that database as that
+    // user, instead of on synthetic catalogs.
+    void uiFrames() {
+        std::printf("%-10s %-10s %8s %10s %10s\n", "books", "event", "events", "p50 us", "p99 us");
+
+        auto db_path = std::getenv("LIBRARY_BENCH_DB");
+        auto username = std::getenv("LIBRARY_BENCH_USER");
+        if (not db_path || not username) {
+            for (auto n : catalog_sizes) {
+                syntheticHome(n);
+            }
+            return;
+        }
+
+        db = std::make_unique<Librarydb>(db_path);
+        auto users = db->getAllUsers();
+        auto usr = std::ranges::find(users, std::string{username}, [](const UserPtr& u) { return u->username; });
+        if (usr == users.end())
+            std::printf("No user %s in %s\n", username, db_path);
+        else
+            report(db->getCatalog().size(), runScript(**usr, homeScript()));
+        db.reset();
+    }
+
+    RegisterBenchmark ui_frames{"ui/frames", uiFrames};
+}
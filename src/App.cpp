@@ -1,7 +1,13 @@
 #include "App.hpp"
 #include "Book.hpp"
+#include "CatalogIndex.hpp"
 #include "Librarydb.hpp"
+#include "MatchCache.hpp"
+#include "NarrowingFilter.hpp"
+#include "SearchMatcher.hpp"
+#include "TrigramIndex.hpp"
 #include "User.hpp"
+#include "VirtualList.hpp"
 
 #include "SQLiteCpp/Exception.h"
 
@@ -12,20 +18,19 @@
 #include "ftxui/dom/node.hpp"
 #include "ftxui/component/event.hpp"
 
-#include <algorithm> // all_of, none_of, any_of
+#include <algorithm> // all_of, none_of, any_of, ranges::sort
 #include <cctype> // isdigit
-#include <chrono> // system_clock
+#include <chrono> // system_clock, seconds
 #include <cstddef> // size_t
 #include <cstdlib> // EXIT_FAILURE, EXIT_SUCCESS
 #include <fstream> // ifstream, ofstream
 #include <functional> // hash
 #include <iostream> // cerr
 #include <memory> // make_unique
-#include <exception> // exception
+#include <optional> // optional
+#include <exception> // exception, exception_ptr, rethrow_exception
 #include <stdexcept> // runtime_error
 #include <string> // string
-#include <thread> // thread
-#include <regex> // regex, regex_match
 #include <vector> // vector
 
 using Action = std::function<void()>;
@@ -52,6 +57,38 @@ ftxui::MenuEntryOption menuEntryOption(){
     return std::move(option);
 }
 
+// Indices of the books or users the predicate keeps, in order. Drives a VirtualList
+template<class Items, class Predicate>
+std::vector<int> filterRows(const Items& items, Predicate&& keep) {
+    std::vector<int> rows;
+    for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+        if (keep(items[i]))
+            rows.push_back(i);
+    }
+    return rows;
+}
+
+// Slots of the candidate books in the catalog, in catalog order. Nothing when
+// the index has no candidates, as for queries shorter than a trigram
+std::optional<std::vector<int>> candidateSlots(const CatalogIndex& catalog, const std::optional<std::vector<std::size_t>>& candidates) {
+    if (not candidates)
+        return std::nullopt;
+    std::vector<int> slots;
+    slots.reserve(candidates->size());
+    for (auto book_id : *candidates) {
+        auto slot = catalog.slotOf(book_id);
+        if (slot != CatalogIndex::npos)
+            slots.push_back(static_cast<int>(slot));
+    }
+    std::ranges::sort(slots);
+    return slots;
+}
+
+// Keep a selection inside a vector that just lost an item
+void clampSelection(int& selected, std::size_t size) {
+    selected = std::max(0, std::min(selected, static_cast<int>(size) - 1));
+}
+
 ftxui::MenuOption menuOption() {
     using namespace ftxui;
     auto option = MenuOption();
@@ -112,6 +149,8 @@ ftxui::ButtonOption buttonOption() {
 }
 
 int App::run() {
+    // A button action that runs as a task fails like any other, on the UI thread and into the catches below
+    UiTask::report = [](std::exception_ptr error) { postToScreen([error] { std::rethrow_exception(error); }); };
     try {
         login();
     }
@@ -154,14 +193,26 @@ void App::attemptRestore() {
     }
 }
 
-void App::flip(bool& flag) {
-    auto th = std::thread([&flag] {
-        flag = not flag;
-        std::this_thread::sleep_for(std::chrono::seconds{2});;
-        screen.PostEvent(ftxui::Event::Custom);
-        flag = not flag;
-    });
-    th.detach();
+void App::flip(bool& flag, TimerWheel::Scope& timers) {
+    flag = not flag;
+    timers.after(std::chrono::seconds{2}, [&flag] { flag = not flag; });
+}
+
+void App::showHome(const User& usr) {
+    active_user = std::make_unique<User>(usr);
+    home();
+}
+
+void App::loop(ftxui::Component root) {
+    if (driver)
+        driver(std::move(root));
+    else
+        screen.Loop(std::move(root));
+}
+
+void App::postToScreen(std::function<void()> closure) {
+    screen.Post(std::move(closure));
+    screen.PostEvent(ftxui::Event::Custom);
 }
 
 void App::saveSession() {
@@ -223,8 +274,9 @@ void App::login() {
         });
 
 
-    // When a login fails, this comes up.
+    // When a login fails, this comes up. For a while
     bool show_failed_authentication = false;
+    TimerWheel::Scope timers{timer_wheel};
     auto failed_login = Renderer([&] {
         return text("Login failed. Wrong credentials!") | color(Color::Red);
     }) | Maybe(&show_failed_authentication);
@@ -271,7 +323,7 @@ void App::login() {
         else {
             // login failed
             login_password.clear();
-            flip(show_failed_authentication);
+            flip(show_failed_authentication, timers);
         }
     };
 
@@ -337,7 +389,7 @@ void App::login() {
     });
 
     // Finally, keep it all in the loop
-    screen.Loop(login_signup_renderer);
+    loop(login_signup_renderer);
 }
 
 void App::adminHome() {
@@ -345,6 +397,11 @@ void App::adminHome() {
     using namespace ftxui;
     std::string username = active_user->username;
 
+    // Expires when this screen is left. Database calls still in flight then are dropped, not resumed
+    auto screen_alive = std::make_shared<bool>(true);
+    // Alerts of this screen going away. Pending ones are cancelled when the screen is left
+    TimerWheel::Scope timers{timer_wheel};
+
     std::vector<std::string> main_selection {
         "Add a book",
         "Book management",
@@ -356,49 +413,64 @@ void App::adminHome() {
     BookStack all_books = db->getAllBooks();
     Users all_users = db->getAllUsers();
 
-    // Buffer for search text
+    // Buffer for search text, and its matcher rebuilt only when the text changes
     std::string searchString;
+    SearchMatcher matcher;
+
+    // Titles and authors by trigram, and where each book sits in all_books.
+    // A search only matches the books at the slots of its candidates
+    TrigramIndex book_index{all_books};
+    CatalogIndex catalog{all_books};
+
+    // Is the book shown under the current search?
+    auto showBook = [&](const BookPtr& book) {
+        return matcher.empty() || isSearchResult(book, matcher);
+    };
 
     // Main manu selector
     int main_menu_selected = 0;
     auto main_menu = Menu(&main_selection, &main_menu_selected, menuOption());
 
-    // All books main menu item
-    int all_book_selected = 0;
-    auto all_book_menu = Container::Vertical({}, &all_book_selected);
-
-    // Add books to the book management menu
-    for(int i = 0; i<all_books.size(); ++i){
-        all_book_menu->Add(
-            MenuEntry(all_books[i]->author + "_" + all_books[i]->title, menuEntryOption()) | Maybe([&, i] {
-                return searchString.empty() || isSearchResult(all_books[i], searchString);
-            })
-        );
-    }
+    // Is the user shown under the current search?
+    auto showUser = [&](const UserPtr& usr) {
+        return matcher.empty() || isSearchResult(usr, matcher);
+    };
 
-    all_book_menu |= size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
+    // All books main menu item. Only the rows in view are ever built
+    int all_book_selected = 0;
+    std::vector<int> book_rows = filterRows(all_books, showBook);
+    auto all_book_menu = VirtualList(&book_rows, &all_book_selected, {
+        [&](int i) { return all_books[i]->author + "_" + all_books[i]->title; },
+        menuEntryOption()
+    }) | size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
 
     // Users management menu
     int all_user_selected = 0;
-    auto all_user_menu = Container::Vertical({}, &all_user_selected);
+    std::vector<int> user_rows = filterRows(all_users, showUser);
+    auto all_user_menu = VirtualList(&user_rows, &all_user_selected, {
+        [&](int i) { return all_users[i]->username + "_" + all_users[i]->email; },
+        menuEntryOption()
+    }) | size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
 
-    // Put users data on the menu, for users management
-    for(int i = 0; i<all_users.size(); ++i){
-        all_user_menu->Add(
-            MenuEntry(all_users[i]->username + "_" + all_users[i]->email, menuEntryOption()) | Maybe([&, i] {
-                return searchString.empty() || isSearchResult(all_users[i], searchString);
-            })
-        );
-    }
-
-    all_user_menu |= size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
+    // Rows of each menu, narrowed while the search text grows
+    NarrowingFilter book_filter, user_filter;
 
     // search Area container creator
-    auto searchArea = [&searchString] {
+    auto searchArea = [&] {
+        auto option = inputOption();
+        option.on_change = [&] {
+            matcher.set(searchString);
+            // Narrowing rechecks only the rows of the last query, which already came from its candidates
+            std::optional<std::vector<int>> candidates;
+            if (not book_filter.narrows(matcher.pattern()))
+                candidates = candidateSlots(catalog, book_index.candidates(searchString));
+            book_filter.apply(matcher.pattern(), all_books, showBook, book_rows, candidates);
+            user_filter.apply(matcher.pattern(), all_users, showUser, user_rows);
+        };
         return Container::Horizontal({
             Renderer([] { return filler(); }),
             Renderer([] { return text("Search: "); }),
-            Input(&searchString, "  here  ", inputOption()) | size(ftxui::WIDTH, ftxui::EQUAL, 10)
+            Input(&searchString, "  here  ", option) | size(ftxui::WIDTH, ftxui::EQUAL, 10)
         });
     };
 
@@ -456,7 +528,7 @@ void App::adminHome() {
 
         // If missing, DARN
         if(required_field_missing_error) {
-            flip(show_error_alert);
+            flip(show_error_alert, timers);
             return;
         }
 
@@ -473,19 +545,16 @@ void App::adminHome() {
         book->pub_year = add_book_pub_year.empty() ? -1 : std::stoi(add_book_pub_year);
         book->edition = add_book_edition.empty() ? -1 : std::stoi(add_book_edition);
 
-        // add the new book to the database, working copy and menu
+        // add the new book to the database, working copy, search index and menu
         db->addBook(book);
-        auto indx = all_books.size();
         all_books.push_back(book);
-        all_book_menu->ChildAt(0)->Add(
-            MenuEntry(book->author + "_" + book->title, menuEntryOption()) | Maybe([&, indx] {
-                return searchString.empty() || isSearchResult(all_books[indx], searchString);
-            })
-        );
+        book_index.add(*book);
+        catalog = CatalogIndex{all_books};
+        book_rows = filterRows(all_books, showBook);
 
         // show success message
         success_message = "Book added successfully";
-        flip(show_success_alert);
+        flip(show_success_alert, timers);
 
         //clear things up
         add_book_title.clear();
@@ -591,7 +660,7 @@ void App::adminHome() {
     };
 
     // Make the actual changes
-    auto save_chages_button_action = [&] {
+    auto save_chages_button_action = [&]() -> UiTask {
         // Check if anything is missing
         bool required_field_missing_error = true;
         if(add_book_title.empty()) {
@@ -609,26 +678,32 @@ void App::adminHome() {
 
         // If something is missing, TOO BAD
         if(required_field_missing_error) {
-            flip(show_error_alert);
-            return;
+            flip(show_error_alert, timers);
+            co_return;
         }
 
         // Find the book in question
         auto book = all_books[all_book_selected];
 
-        // Edit the book data
-        book->title = add_book_title;
-        book->author = add_book_author;
-        book->quantity = std::stoi(add_book_quantity);
-        book->publisher = add_book_publisher;
-        book->pub_year = add_book_pub_year.empty() ? -1 : std::stoi(add_book_pub_year);
-        book->edition = add_book_edition.empty() ? -1 : std::stoi(add_book_edition);
-        book->description = add_book_description;
-
-        // Make the changes permanent, in database
-        db->updateBook(book);
-        // Finally, clean the house and editing is over
+        // Edit a copy of the book data. The database thread writes it out while
+        // the menus keep showing the book as it was
+        auto edited = std::make_shared<Book>(*book);
+        edited->title = add_book_title;
+        edited->author = add_book_author;
+        edited->quantity = std::stoi(add_book_quantity);
+        edited->publisher = add_book_publisher;
+        edited->pub_year = add_book_pub_year.empty() ? -1 : std::stoi(add_book_pub_year);
+        edited->edition = add_book_edition.empty() ? -1 : std::stoi(add_book_edition);
+        edited->description = add_book_description;
+
+        // Editing is over, clean the house
         leave_edit_dialog_action();
+
+        // Make the changes permanent, in database, then in memory and searchable under the new title and author
+        co_await async_db.call(screen_alive, [edited] { db->updateBook(edited); });
+        *book = *edited;
+        book_index.update(*book);
+        book_rows = filterRows(all_books, showBook);
     };
 
     // Book editing widgets in one house
@@ -656,11 +731,20 @@ void App::adminHome() {
         });
 
     // Remove a book a book with this action
-    auto remove_book_button_action = [&] {
-        db->removeBook(all_books[all_book_selected]->book_id);
-        all_books.erase(all_books.begin() + all_book_selected);
+    auto remove_book_button_action = [&]() -> UiTask {
+        auto book = all_books[all_book_selected];
+        co_await async_db.call(screen_alive, [book_id = book->book_id] { db->removeBook(book_id); });
+
+        // The menu may have moved on meanwhile. Find the book again, if an earlier click didn't remove it already
+        auto it = std::ranges::find(all_books, book);
+        if (it == all_books.end())
+            co_return;
+        book_index.remove(book->book_id);
+        all_books.erase(it);
+        catalog = CatalogIndex{all_books};
         // Remove from book menu
-        all_book_menu->ChildAt(0)->ChildAt(all_user_selected)->Detach();
+        clampSelection(all_book_selected, all_books.size());
+        book_rows = filterRows(all_books, showBook);
     };
     auto remove_book_button = Button("Remove", remove_book_button_action, buttonOption());
 
@@ -669,7 +753,8 @@ void App::adminHome() {
         db->removeUser(all_users[all_user_selected]->username);
         all_users.erase(all_users.begin() + all_user_selected);
         //Remove from the menu
-        all_user_menu->ChildAt(0)->ChildAt(all_user_selected)->Detach();
+        clampSelection(all_user_selected, all_users.size());
+        user_rows = filterRows(all_users, showUser);
     };
     auto remove_user_button = Button("Remove", remove_user_button_action, buttonOption());
 
@@ -739,7 +824,7 @@ void App::adminHome() {
             })
         }) | Maybe([&] { return ! all_users.empty(); }),
 
-        accountMgmtScreen(new_password, password_change_success, deleting_account)
+        accountMgmtScreen(new_password, password_change_success, deleting_account, timers)
 
     }, &main_menu_selected);
 
@@ -774,7 +859,7 @@ void App::adminHome() {
     }) | border;
 
     // Off we go. It is all displayed
-    screen.Loop(home_screen);
+    loop(home_screen);
 }
 
 void App::normalHome() {
@@ -783,34 +868,57 @@ void App::normalHome() {
 
     std::string username = active_user->username;
 
+    // Expires when this screen is left. Database calls still in flight then are dropped, not resumed
+    auto screen_alive = std::make_shared<bool>(true);
+    // Alerts of this screen going away. Pending ones are cancelled when the screen is left
+    TimerWheel::Scope timers{timer_wheel};
+
     // Fetch all books from database
     BookStack all_books = db->getAllBooks();
 
-    auto findBook = [&](const std::size_t book_id) -> BookPtr {
-        auto ptr = std::ranges::find_if(all_books, [&](const BookPtr& book) {
-            return book->book_id == book_id;
-        });
-
-        return *ptr;
-    };
+    // Where each book sits in all_books, and which of those slots this user borrowed and liked
+    CatalogIndex catalog{all_books};
+    SlotSet borrowed_slots{catalog.size()};
+    SlotSet favourite_slots{catalog.size()};
 
-    // Fetch borrowed books
-    BookStack borrowed_books = db->getBorrowed(username);
+    // Fetch borrowed books. Only their ids, the books themselves are already loaded
     BookStack borrowed;
-    for(auto book : borrowed_books) {
-        borrowed.push_back(findBook(book->book_id));
+    for(auto book_id : db->getBorrowedIds(username)) {
+        auto slot = catalog.slotOf(book_id);
+        if (slot == CatalogIndex::npos)
+            continue;
+        borrowed.push_back(all_books[slot]);
+        borrowed_slots.insert(slot);
     }
-    borrowed_books.clear();
 
     // Fetch favourite books
-    BookStack favourites_books = db->getFavourites(username);
     BookStack favourites;
-    for (auto book : favourites_books) {
-        favourites.push_back(findBook(book->book_id));
+    for (auto book_id : db->getFavouriteIds(username)) {
+        auto slot = catalog.slotOf(book_id);
+        if (slot == CatalogIndex::npos)
+            continue;
+        favourites.push_back(all_books[slot]);
+        favourite_slots.insert(slot);
     }
-    favourites_books.clear();
 
+    // Buffer for search text, and its matcher rebuilt only when the text changes
     std::string searchString;
+    SearchMatcher matcher;
+
+    // Titles and authors by trigram. A search only matches the books at the slots of its candidates
+    TrigramIndex book_index{all_books};
+
+    // Answers of the current search by catalog slot. Borrowed and favourite
+    // books are also in all_books, so each book is matched once per query
+    MatchCache book_matches{catalog.size()};
+
+    // Is the book shown under the current search?
+    auto showBook = [&](const BookPtr& book) {
+        if (matcher.empty())
+            return true;
+        return book_matches.matches(catalog.slotOf(book->book_id), [&] { return isSearchResult(book, matcher); });
+    };
+
     std::vector<std::string> main_selection {
         "All books",
         "Borrowed",
@@ -822,62 +930,55 @@ void App::normalHome() {
     int main_menu_selected = 0;
     auto main_menu = Menu(&main_selection, &main_menu_selected, menuOption());
 
-    // All books main menu item
-    int all_book_selected = 0;
-    auto all_book_menu = Container::Vertical({}, &all_book_selected);
-
-    // Add books to the menu
-    for(int i = 0; i<all_books.size(); ++i){
-        all_book_menu->Add(
-            MenuEntry(all_books[i]->author + "_" + all_books[i]->title, menuEntryOption()) | Maybe([&, i] {
-                return searchString.empty() || isSearchResult(all_books[i], searchString);
-            })
-        );
-    }
+    // Label of a book row, in any of the book menus
+    auto bookLabel = [](const BookStack& books) {
+        return [&books](int i) { return books[i]->author + "_" + books[i]->title; };
+    };
 
-    all_book_menu |= size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
+    // All books main menu item. Only the rows in view are ever built
+    int all_book_selected = 0;
+    std::vector<int> all_book_rows = filterRows(all_books, showBook);
+    auto all_book_menu = VirtualList(&all_book_rows, &all_book_selected, {bookLabel(all_books), menuEntryOption()})
+        | size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
 
     // Favourite books main menu item
     int favourite_book_selected = 0;
-    auto favourites_menu = Container::Vertical({}, &favourite_book_selected);
-
-    // Favaourites in the menu
-    for(int i = 0; i<favourites.size(); ++i){
-        favourites_menu->Add(
-            MenuEntry(favourites[i]->author + "_" + favourites[i]->title, menuEntryOption()) | Maybe([&, i] {
-                return searchString.empty() || isSearchResult(favourites[i], searchString);
-            })
-        );
-    }
-
-   favourites_menu |= size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
+    std::vector<int> favourite_rows = filterRows(favourites, showBook);
+    auto favourites_menu = VirtualList(&favourite_rows, &favourite_book_selected, {bookLabel(favourites), menuEntryOption()})
+        | size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
 
     // borrowed books main manu item
     int borrowed_book_selected = 0;
-    auto borrowed_menu = Container::Vertical({}, &borrowed_book_selected);
-
-    // Add borrowed books to the borrowed books menu
-    for(int i = 0; i<borrowed.size(); ++i) {
-        borrowed_menu->Add(
-            MenuEntry(borrowed[i]->author + "_" + borrowed[i]->title, menuEntryOption()) | Maybe([&, i] {
-                return searchString.empty() || isSearchResult(borrowed[i], searchString);
-            })
-        );
-    }
+    std::vector<int> borrowed_rows = filterRows(borrowed, showBook);
+    auto borrowed_menu = VirtualList(&borrowed_rows, &borrowed_book_selected, {bookLabel(borrowed), menuEntryOption()})
+        | size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
 
-    borrowed_menu |= size(ftxui::WIDTH, ftxui::EQUAL, entryMenuSize);
+    // Rows of each menu, narrowed while the search text grows
+    NarrowingFilter all_book_filter, favourite_filter, borrowed_filter;
 
     // search Area container creator
-    auto searchArea = [&searchString] {
+    auto searchArea = [&] {
+        auto option = inputOption();
+        option.on_change = [&] {
+            matcher.set(searchString);
+            book_matches.invalidate();
+            // Narrowing rechecks only the rows of the last query, which already came from its candidates
+            std::optional<std::vector<int>> candidates;
+            if (not all_book_filter.narrows(matcher.pattern()))
+                candidates = candidateSlots(catalog, book_index.candidates(searchString));
+            all_book_filter.apply(matcher.pattern(), all_books, showBook, all_book_rows, candidates);
+            favourite_filter.apply(matcher.pattern(), favourites, showBook, favourite_rows);
+            borrowed_filter.apply(matcher.pattern(), borrowed, showBook, borrowed_rows);
+        };
         return Container::Horizontal({
             Renderer([] { return filler(); }),
             Renderer([] { return text("Search: "); }),
-            Input(&searchString, "  here  ", inputOption()) | size(ftxui::WIDTH, ftxui::EQUAL, 10)
+            Input(&searchString, "  here  ", option) | size(ftxui::WIDTH, ftxui::EQUAL, 10)
         });
     };
 
     // What happens when a book is borrowed
-    auto borrow_button_action = [&] {
+    auto borrow_button_action = [&]() -> UiTask {
         BookPtr book;
         // The book borrowing can be done from all_books tab or favourites tab.
         // Appropriate book must be selected based on condition
@@ -888,40 +989,35 @@ void App::normalHome() {
             book = favourites[favourite_book_selected];
         }
 
-        // Try borrowing. If a book is already borrowed, an error is thrown.
-        // In that case, just quietly return. Meaning DO NOTHING.
-        try {
-            db->borrow(username, book->book_id);
-        }
-        catch(const SQLite::Exception& e){
-            //TODO: if UNIQUE constraint error, return. Else throw.
-            //e.getErrorCode();
-            return;
-        }
+        // Try borrowing. Nothing changes unless it went through.
+        // Real database errors are not caught here; they end the app as any other does
+        auto result = co_await async_db.call(screen_alive, [username, book_id = book->book_id] {
+            return db->borrow(username, book_id);
+        });
+        if (result == BorrowResult::OUT_OF_STOCK)
+            book->quantity = 0; // someone else took the last copy
+        if (result != BorrowResult::OK)
+            co_return;
 
         // one borrowed, minus one from available books
         --book->quantity;
 
         // Add newly borrowed book to the in-memory catalog of borrowed books
-        auto indx = borrowed.size();
         borrowed.push_back(book);
+        borrowed_slots.insert(catalog.slotOf(book->book_id));
 
         // New book is borrowed. Put it on the borrowed menu
-        borrowed_menu->ChildAt(0)->Add(
-            MenuEntry(borrowed[indx]->author + "_" + borrowed[indx]->title, menuEntryOption()) | Maybe([&, indx] {
-                return searchString.empty() || isSearchResult(borrowed[indx], searchString);
-            })
-        );
+        borrowed_rows = filterRows(borrowed, showBook);
     };
 
-    // This finds out if a book is already borrowed
+    // This finds out if a book is already borrowed. One bit lookup, by the book's slot
     auto isBorrowed = [&](const BookPtr& book) -> bool {
-        return std::ranges::any_of(borrowed, [&](const BookPtr& bok) { return book == bok; });
+        return borrowed_slots.contains(catalog.slotOf(book->book_id));
     };
 
     // The button to borrow books
     auto borrow_button = Button("Borrow", borrow_button_action, buttonOption()) | Renderer([&](Element borrow) {
-        if (isBorrowed(all_books[all_book_selected])) {
+        if (borrowed_slots.contains(all_book_selected)) {
             // When borrowed, say "borrowed"
             return text("Borrowed ");
         }
@@ -932,7 +1028,7 @@ void App::normalHome() {
     });
 
     // What does it mean to like a book?
-    auto like_button_action = [&] {
+    auto like_button_action = [&]() -> UiTask {
         BookPtr book;
         // Liking can be from borrowed tab or all_books tab. Act accordingly
         if (main_menu_selected == 0) {
@@ -944,34 +1040,30 @@ void App::normalHome() {
 
         // Try liking. If error, it is already liked. Ignore that.
         try {
-            db->addFavourite(username, book->book_id);
+            co_await async_db.call(screen_alive, [username, book_id = book->book_id] { db->addFavourite(username, book_id); });
         }
         catch(const SQLite::Exception& e){
             //TODO: if UNIQUE constraint error, return. Else throw.
             //e.getErrorCode();
-            return;
+            co_return;
         }
 
         // We have a new like at hand. Place it in the ranks of favourites in memory
-        auto indx = favourites.size();
         favourites.push_back(book);
+        favourite_slots.insert(catalog.slotOf(book->book_id));
 
         // In the menu too
-        favourites_menu->ChildAt(0)->Add(
-            MenuEntry(favourites[indx]->author + "_" + favourites[indx]->title, menuEntryOption()) | Maybe([&, indx] {
-                return searchString.empty() || isSearchResult(favourites[indx], searchString);
-            })
-        );
+        favourite_rows = filterRows(favourites, showBook);
     };
 
-    // Is it liked? How would we know?
+    // Is it liked? How would we know? Its bit in the favourite slots
     auto isFavourite = [&](const BookPtr& book) -> bool {
-        return std::ranges::any_of(favourites, [&](const BookPtr& bok) { return book == bok; });
+        return favourite_slots.contains(catalog.slotOf(book->book_id));
     };
 
     // Like button.
     auto like_button = Button("Like", like_button_action, buttonOption()) | Renderer([&](Element like) {
-        if (isFavourite(all_books[all_book_selected])) {
+        if (favourite_slots.contains(all_book_selected)) {
             return text(" Liked");
         }
         else {
@@ -980,28 +1072,42 @@ void App::normalHome() {
     });
 
     // This is return action. This is THE WAY to return books
-    auto unborrow_button_action = [&] {
+    auto unborrow_button_action = [&]() -> UiTask {
         // Register with the database
-        db->unborrow(username, borrowed[borrowed_book_selected]->book_id);
+        auto book = borrowed[borrowed_book_selected];
+        co_await async_db.call(screen_alive, [username, book_id = book->book_id] { db->unborrow(username, book_id); });
+
+        // Already gone if this was a second click on the same book
+        auto it = std::ranges::find(borrowed, book);
+        if (it == borrowed.end())
+            co_return;
 
         // The is book is return. Increase the available quantity
-        ++borrowed[borrowed_book_selected]->quantity;
+        ++book->quantity;
 
         // delete from borrowed books working copy
-        borrowed.erase(borrowed.begin() + borrowed_book_selected);
+        borrowed_slots.erase(catalog.slotOf(book->book_id));
+        borrowed.erase(it);
         // Remove from the menu
-        borrowed_menu->ChildAt(0)->ChildAt(borrowed_book_selected)->Detach();
+        clampSelection(borrowed_book_selected, borrowed.size());
+        borrowed_rows = filterRows(borrowed, showBook);
     };
     auto unborrow_button = Button("Return", unborrow_button_action, buttonOption());
 
     // No longer like this book. Banish it from liked books.
-    auto unlike_button_action = [&] {
+    auto unlike_button_action = [&]() -> UiTask {
         // remove from database
-        db->removeFavourite(username, favourites[favourite_book_selected]->book_id);
+        auto book = favourites[favourite_book_selected];
+        co_await async_db.call(screen_alive, [username, book_id = book->book_id] { db->removeFavourite(username, book_id); });
+        auto it = std::ranges::find(favourites, book);
+        if (it == favourites.end())
+            co_return;
         // remove from working copy of favourites
-        favourites.erase(favourites.begin() + favourite_book_selected);
+        favourite_slots.erase(catalog.slotOf(book->book_id));
+        favourites.erase(it);
         // Remove from the favourites menu
-        favourites_menu->ChildAt(0)->ChildAt(favourite_book_selected)->Detach();
+        clampSelection(favourite_book_selected, favourites.size());
+        favourite_rows = filterRows(favourites, showBook);
     };
     auto unlike_button = Button("Unlike", unlike_button_action, buttonOption());
 
@@ -1016,7 +1122,7 @@ void App::normalHome() {
     auto rate_button = [&](int n) {
         return Button(std::string(n, '*'), [&, n]{
             auto book = borrowed[borrowed_book_selected];
-            book->rating = db->rateBook(book->book_id, n);
+            book->rating = db->rateBook(username, book->book_id, n);
             show_rate_dialog = false;
         }, buttonOption());
     };
@@ -1115,7 +1221,7 @@ void App::normalHome() {
         }) | Maybe([&] { return ! favourites.empty(); }),
 
         // account tab
-        accountMgmtScreen(new_password, password_change_success, deleting_account)
+        accountMgmtScreen(new_password, password_change_success, deleting_account, timers)
 
     }, &main_menu_selected);
 
@@ -1150,7 +1256,7 @@ void App::normalHome() {
     }) | border;
 
     // All done, now loop it
-    screen.Loop(home_screen);
+    loop(home_screen);
 }
 
 void App::home() {
@@ -1219,22 +1325,21 @@ ftxui::Component App::userDetail(const Users& users, const int& selector) {
 }
 
 // Does a book meet search criteria?
-bool App::isSearchResult(const BookPtr& book, const std::string& searchString) {
-    std::regex pattern {".*" + searchString + ".*", std::regex_constants::icase};
-    return std::regex_match(book->title, pattern) || std::regex_match(book->author, pattern);
+bool App::isSearchResult(const BookPtr& book, const SearchMatcher& matcher) {
+    return matcher.matches(book->title) || matcher.matches(book->author);
 }
 
 // Does a user meet search criteria?
-bool App::isSearchResult(const UserPtr& usr, const std::string& searchString) {
-    std::regex pattern {".*" + searchString + ".*", std::regex_constants::icase};
-    return std::regex_match(usr->username, pattern) || std::regex_match(usr->email, pattern);
+bool App::isSearchResult(const UserPtr& usr, const SearchMatcher& matcher) {
+    return matcher.matches(usr->username) || matcher.matches(usr->email);
 }
 
 // Changing account information
-ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& password_change_success, bool& deleting_account) {
+ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& password_change_success, bool& deleting_account,
+                                       TimerWheel::Scope& timers) {
     using namespace ftxui;
     // Succes alert after password change. Defining here is saves from rewritting in two places later
-    static auto success_alert = [&] {
+    auto success_alert = [] {
          return Container::Horizontal({
             Renderer([]{ return filler(); }),
             Renderer([] { return text("Password changed successfully") | color(Color::Green); }),
@@ -1243,7 +1348,7 @@ ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& passwor
     };
 
     // ERROR. Defining here is saves from rewritting in two places later
-    static auto error_alert = [&](const std::string txt) {
+    auto error_alert = [](const std::string txt) {
          return Container::Horizontal({
             Renderer([]{ return filler(); }),
             Renderer([txt] { return text(txt) | color(Color::Red); }),
@@ -1251,13 +1356,13 @@ ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& passwor
         });
     };
 
-    // THIS is done to change password
-    static auto change_password_action = [&] {
+    // THIS is done to change password. Built for each screen, on that screen's buffer, flag and timers
+    auto change_password_action = [this, &new_password, &password_change_success, &timers] {
         if(new_password.size() < 4)
             return;
         db->changePassword(active_user->username, new_password);
         new_password.clear();
-        flip(password_change_success);
+        flip(password_change_success, timers);
     };
 
     // Root is special. Can't be removed, even by root itself.
@@ -1269,7 +1374,7 @@ ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& passwor
             }),
             success_alert() | Maybe(&password_change_success),
             Button("Change passoword", change_password_action, buttonOption())
-            }) | CatchEvent([&](Event e) {
+            }) | CatchEvent([change_password_action](Event e) {
                 if (e == Event::Return) {
                     change_password_action();
                     return true;
@@ -1308,7 +1413,7 @@ ftxui::Component App::accountMgmtScreen(std::string& new_password, bool& passwor
                 Renderer([] { return filler(); })
             })
         }) | Maybe(&deleting_account)
-    }) | CatchEvent([&](Event e) {
+    }) | CatchEvent([change_password_action](Event e) {
         if (e == Event::Return) {
             change_password_action();
             return true;
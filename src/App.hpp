@@ -1,10 +1,15 @@
 #pragma once
 
+#include "AsyncDb.hpp"
 #include "Book.hpp"
+#include "SearchMatcher.hpp"
+#include "TimerWheel.hpp"
 #include "User.hpp"
 
+#include "ftxui/component/event.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 
+#include <functional> // function
 #include <memory> // unique_ptr
 #include <filesystem> // path
 
@@ -13,11 +18,25 @@ class App {
     public:
         int run();
 
+        // Goes straight to the home screen of usr, without logging in or touching the session
+        void showHome(const User& usr);
+
         bool newSession = false;
         std::filesystem::path session_file;
+
+        // Runs a screen until it is left. Unset, that is screen.Loop() on the
+        // terminal; the frame benchmark sets it to feed events and render off-screen
+        std::function<void(ftxui::Component)> driver;
+
+        // Whether a row is shown under the current search
+        static bool isSearchResult(const BookPtr& book, const SearchMatcher& matcher);
+        static bool isSearchResult(const UserPtr& usr, const SearchMatcher& matcher);
     private:
         void login();
 
+        // Hands a screen's root component to the driver, or to the terminal
+        void loop(ftxui::Component root);
+
         void attemptRestore();
 
         void home();
@@ -34,16 +53,23 @@ class App {
 
         ftxui::Component label(const std::string txt);
 
-        bool isSearchResult(const BookPtr& book, const std::string& searchString);
-        bool isSearchResult(const UserPtr& usr, const std::string& searchString);
+        ftxui::Component accountMgmtScreen(std::string& new_password, bool& password_change_success, bool& deleting_account,
+                                           TimerWheel::Scope& timers);
 
-        ftxui::Component accountMgmtScreen(std::string& new_password, bool& password_change_success, bool& deleting_account);
+        // Flips flag now, and back again two seconds later
+        void flip(bool& flag, TimerWheel::Scope& timers);
 
-        void flip(bool& flag);
+        // Runs a closure on the UI thread, and redraws
+        static void postToScreen(std::function<void()> closure);
 
         int entryMenuSize = 70;
         inline static ftxui::ScreenInteractive screen = ftxui::ScreenInteractive::Fullscreen();
         std::unique_ptr<User> active_user;
+
+        // Database calls of button actions. They complete on the UI thread, through the event loop
+        AsyncDb async_db{postToScreen};
+        // Timed changes of UI state, such as alerts going away
+        TimerWheel timer_wheel{postToScreen};
 };
 
 inline std::unique_ptr<App> ap;
@@ -0,0 +1,33 @@
+#include "AsyncDb.hpp"
+
+AsyncDb::~AsyncDb() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void AsyncDb::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void AsyncDb::work() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            wake.wait(lock, [this] { return stopping || not jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable> // condition_variable
+#include <coroutine> // coroutine_handle, suspend_never
+#include <deque> // deque
+#include <exception> // exception_ptr, current_exception, rethrow_exception
+#include <functional> // function
+#include <memory> // weak_ptr
+#include <mutex> // mutex
+#include <optional> // optional
+#include <thread> // thread
+#include <type_traits> // invoke_result_t, conditional_t, is_void_v
+#include <utility> // move
+
+// Fire-and-forget coroutine, started from a UI event handler. It runs up to its
+// first co_await right away and continues on the UI thread as awaited calls complete.
+struct UiTask {
+    struct promise_type {
+        UiTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        // Kept from whoever resumed the coroutine, so the frame still finishes and is freed
+        void unhandled_exception() noexcept {
+            if (report)
+                report(std::current_exception());
+        }
+    };
+
+    // Gets what a task threw, as its frame finishes. Unset, the exception is dropped
+    inline static std::function<void(std::exception_ptr)> report;
+};
+
+// Runs database calls on a thread of its own, so the UI thread never waits on
+// the disk or a locked database. Calls run one at a time, in the order they
+// were made. Completions go back through `post`, which has to run the closure
+// it is given on the UI thread.
+class AsyncDb {
+    public:
+        using Post = std::function<void(std::function<void()>)>;
+
+        template<class Fn>
+        class Call;
+
+        explicit AsyncDb(Post post) : post(std::move(post)), worker([this] { work(); }) {}
+        ~AsyncDb(); // runs the calls already queued before returning
+
+        AsyncDb(const AsyncDb&) = delete;
+        AsyncDb& operator=(const AsyncDb&) = delete;
+
+        // Awaitable that runs fn on the database thread. The awaiting coroutine
+        // resumes on the UI thread with what fn returned, or with what it threw.
+        // If owner has expired by then, the coroutine is destroyed instead of resumed.
+        template<class Fn>
+        Call<Fn> call(std::weak_ptr<void> owner, Fn fn) { return Call<Fn>{*this, std::move(owner), std::move(fn)}; }
+
+    private:
+        void enqueue(std::function<void()> job);
+        void work();
+
+        Post post;
+        std::mutex mtx; // guards jobs and stopping
+        std::condition_variable wake;
+        std::deque<std::function<void()>> jobs;
+        bool stopping = false;
+        std::thread worker; // declared last, so it starts once everything it uses is ready
+};
+
+template<class Fn>
+class AsyncDb::Call {
+    using Result = std::invoke_result_t<Fn&>;
+
+    public:
+        Call(AsyncDb& async, std::weak_ptr<void> owner, Fn fn) : async(async), owner(std::move(owner)), fn(std::move(fn)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        // The awaiter lives in the suspended coroutine's frame, so the job can
+        // refer to it until the coroutine is resumed or destroyed
+        void await_suspend(std::coroutine_handle<> awaiting) {
+            async.enqueue([this, awaiting] {
+                try {
+                    if constexpr (std::is_void_v<Result>)
+                        fn();
+                    else
+                        result.emplace(fn());
+                }
+                catch(...) {
+                    error = std::current_exception();
+                }
+                async.post([this, awaiting] {
+                    if (owner.expired())
+                        awaiting.destroy();
+                    else
+                        awaiting.resume();
+                });
+            });
+        }
+
+        Result await_resume() {
+            if (error)
+                std::rethrow_exception(error);
+            if constexpr (not std::is_void_v<Result>)
+                return std::move(*result);
+        }
+
+    private:
+        AsyncDb& async;
+        std::weak_ptr<void> owner;
+        Fn fn;
+        std::optional<std::conditional_t<std::is_void_v<Result>, bool, Result>> result;
+        std::exception_ptr error;
+};
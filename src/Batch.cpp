@@ -0,0 +1,326 @@
+#include "Batch.hpp"
+#include "Book.hpp"
+#include "BookCatalog.hpp"
+#include "SearchMatcher.hpp"
+#include "User.hpp"
+
+#include <algorithm> // sort
+#include <chrono> // steady_clock, system_clock
+#include <cstdio> // snprintf
+#include <functional> // function, hash
+#include <map> // map
+#include <memory> // make_shared
+#include <optional> // optional
+#include <stdexcept> // invalid_argument, runtime_error
+#include <string> // string, getline, stoi, stoull
+#include <vector> // vector
+
+namespace {
+    using Args = std::vector<std::string>;
+
+    // Splits a command line on spaces. Double quotes group words, and \" or \\ inside them escape
+    Args tokenize(const std::string& line) {
+        Args args;
+        std::string current;
+        bool in_token = false, quoted = false;
+        for (std::size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '\\' && i + 1 < line.size() && (line[i + 1] == '"' || line[i + 1] == '\\'))
+                    current += line[++i];
+                else if (c == '"')
+                    quoted = false;
+                else
+                    current += c;
+            }
+            else if (c == '"') {
+                quoted = in_token = true;
+            }
+            else if (c == ' ' || c == '\t' || c == '\r') {
+                if (in_token)
+                    args.push_back(std::move(current));
+                current.clear();
+                in_token = false;
+            }
+            else {
+                current += c;
+                in_token = true;
+            }
+        }
+        if (quoted)
+            throw std::invalid_argument{"unterminated quote"};
+        if (in_token)
+            args.push_back(std::move(current));
+        return args;
+    }
+
+    std::size_t bookId(const std::string& arg) {
+        try {
+            return std::stoull(arg);
+        }
+        catch(const std::exception&) {
+            throw std::invalid_argument{"invalid book id '" + arg + "'"};
+        }
+    }
+
+    int number(const std::string& arg, const char* name) {
+        try {
+            return std::stoi(arg);
+        }
+        catch(const std::exception&) {
+            throw std::invalid_argument{std::string{"invalid "} + name + " '" + arg + "'"};
+        }
+    }
+
+    const char* describe(BorrowResult result) {
+        switch (result) {
+            case BorrowResult::OK: return "borrowed";
+            case BorrowResult::OUT_OF_STOCK: return "out of stock";
+            case BorrowResult::ALREADY_BORROWED: return "already borrowed";
+            case BorrowResult::NO_SUCH_BOOK: return "no such book";
+        }
+        return "unknown";
+    }
+
+    class Session {
+        public:
+            explicit Session(Librarydb& db) : db(db) {}
+
+            // Result line of one command. Throws for errors
+            std::string run(const Args& args);
+
+        private:
+            void expectArgs(const Args& args, std::size_t least, std::size_t most, const char* usage) {
+                if (args.size() - 1 < least || args.size() - 1 > most)
+                    throw std::invalid_argument{std::string{"usage: "} + usage};
+            }
+
+            const std::string& username() {
+                if (not user)
+                    throw std::runtime_error{"not logged in"};
+                return user->username;
+            }
+
+            BookCatalog& loadedCatalog() {
+                if (not catalog)
+                    catalog = db.getCatalog();
+                return *catalog;
+            }
+
+            std::string search(const Args& args);
+            std::string find(const Args& args);
+            std::string stats();
+
+            Librarydb& db;
+            std::optional<User> user;
+            std::optional<BookCatalog> catalog; // for search and stats, loaded on first use
+    };
+
+    std::string Session::run(const Args& args) {
+        const auto& command = args[0];
+        if (command == "login") {
+            expectArgs(args, 2, 2, "login USER PASSWORD");
+            auto found = db.authenticate(args[1], args[2]);
+            if (not found)
+                throw std::runtime_error{"wrong credentials"};
+            user = *found;
+            return "logged in as " + user->username;
+        }
+        if (command == "logout") {
+            expectArgs(args, 0, 0, "logout");
+            user.reset();
+            return "logged out";
+        }
+        if (command == "borrow") {
+            expectArgs(args, 1, 1, "borrow BOOK_ID");
+            auto result = db.borrow(username(), bookId(args[1]));
+            if (result != BorrowResult::OK)
+                throw std::runtime_error{std::string{describe(result)} + " " + args[1]};
+            return "borrowed " + args[1];
+        }
+        if (command == "checkout") {
+            expectArgs(args, 1, 1024, "checkout [BOOK_ID...] [return BOOK_ID...]");
+            std::vector<std::size_t> borrow_ids, return_ids;
+            bool returning = false;
+            for (std::size_t i = 1; i < args.size(); ++i) {
+                if (args[i] == "return")
+                    returning = true;
+                else
+                    (returning ? return_ids : borrow_ids).push_back(bookId(args[i]));
+            }
+            auto done = db.checkout(username(), borrow_ids, return_ids);
+
+            std::size_t borrowed = 0;
+            std::string refused;
+            for (std::size_t i = 0; i < borrow_ids.size(); ++i) {
+                if (done.borrowed[i] == BorrowResult::OK)
+                    ++borrowed;
+                else
+                    refused += ", " + std::to_string(borrow_ids[i]) + " " + describe(done.borrowed[i]);
+            }
+            return "borrowed " + std::to_string(borrowed) + " of " + std::to_string(borrow_ids.size())
+                + ", returned " + std::to_string(done.returned) + " of " + std::to_string(return_ids.size()) + refused;
+        }
+        if (command == "return") {
+            expectArgs(args, 1, 1, "return BOOK_ID");
+            db.unborrow(username(), bookId(args[1]));
+            return "returned " + args[1];
+        }
+        if (command == "like") {
+            expectArgs(args, 1, 1, "like BOOK_ID");
+            db.addFavourite(username(), bookId(args[1]));
+            return "liked " + args[1];
+        }
+        if (command == "rate") {
+            expectArgs(args, 2, 2, "rate BOOK_ID STARS");
+            int stars = number(args[2], "stars");
+            if (stars < 1 || stars > 5)
+                throw std::invalid_argument{"stars must be 1 to 5"};
+            char rating[32];
+            std::snprintf(rating, sizeof rating, "%.2f", db.rateBook(username(), bookId(args[1]), stars));
+            return "rated " + args[1] + ", now " + rating;
+        }
+        if (command == "add-book") {
+            expectArgs(args, 3, 7, "add-book TITLE AUTHOR QUANTITY [PUBLISHER [YEAR [EDITION [DESCRIPTION]]]]");
+            if (not user || user->type != UserClass::ADMIN)
+                throw std::runtime_error{"only admins can add books"};
+            auto book = std::make_shared<Book>();
+            book->title = args[1];
+            book->author = args[2];
+            book->quantity = number(args[3], "quantity");
+            book->publisher = args.size() > 4 ? args[4] : "";
+            book->pub_year = args.size() > 5 ? number(args[5], "year") : -1;
+            book->edition = args.size() > 6 ? number(args[6], "edition") : -1;
+            book->description = args.size() > 7 ? args[7] : "";
+            // Same id scheme as the add book screen
+            book->book_id = std::hash<std::string>{}(
+                book->title + book->author + std::to_string(std::chrono::system_clock::now().time_since_epoch().count())
+            );
+            db.addBook(book);
+            if (catalog)
+                catalog->push_back(*book);
+            return "added " + std::to_string(book->book_id);
+        }
+        if (command == "search") {
+            expectArgs(args, 1, 64, "search TEXT...");
+            return search(args);
+        }
+        if (command == "find") {
+            expectArgs(args, 1, 64, "find WORDS...");
+            return find(args);
+        }
+        if (command == "stats") {
+            expectArgs(args, 0, 0, "stats");
+            return stats();
+        }
+        throw std::invalid_argument{"unknown command '" + command + "'"};
+    }
+
+    // Same matching as the search box: case-insensitive, in title or author
+    std::string Session::search(const Args& args) {
+        std::string text = args[1];
+        for (std::size_t i = 2; i < args.size(); ++i) {
+            text += " " + args[i];
+        }
+
+        loadedCatalog();
+        SearchMatcher matcher{text};
+        auto& titles = catalog->titleColumn();
+        auto& authors = catalog->authorColumn();
+        auto& strings = catalog->internedStrings();
+
+        constexpr std::size_t shown = 10;
+        std::size_t found = 0;
+        std::string ids;
+        for (std::size_t slot = 0; slot < catalog->size(); ++slot) {
+            if (not matcher.matches(titles[slot]) && not matcher.matches(strings[authors[slot]]))
+                continue;
+            if (found++ < shown)
+                ids += " " + std::to_string(catalog->bookIds()[slot]);
+        }
+        return std::to_string(found) + " found" + (found > shown ? ", first" : "") + (found ? ":" : "") + ids;
+    }
+
+    // What the catalog's string pool holds, and what it saves over a std::string per book
+    std::string Session::stats() {
+        auto& books = loadedCatalog();
+        auto& strings = books.internedStrings();
+        return std::to_string(books.size()) + " books, " + std::to_string(strings.size()) + " distinct authors and publishers in "
+            + std::to_string(strings.storedBytes()) + " bytes, " + std::to_string(strings.savedBytes()) + " bytes saved by interning";
+    }
+
+    // Full-text search in the database, best matches first
+    std::string Session::find(const Args& args) {
+        std::string words = args[1];
+        for (std::size_t i = 2; i < args.size(); ++i) {
+            words += " " + args[i];
+        }
+
+        constexpr std::size_t shown = 10;
+        std::string ids;
+        auto books = db.searchBooks(words, shown);
+        for (auto& book : books) {
+            ids += " " + std::to_string(book->book_id);
+        }
+        return std::to_string(books.size()) + " found" + (books.empty() ? "" : ":") + ids;
+    }
+}
+
+BatchSummary runBatch(Librarydb& db, std::istream& in, std::ostream& out, std::ostream& report) {
+    using Clock = std::chrono::steady_clock;
+
+    BatchSummary summary;
+    Session session{db};
+    std::map<std::string, std::vector<double>> timings; // microseconds per command name
+    auto started = Clock::now();
+
+    std::string line;
+    for (std::size_t number = 1; std::getline(in, line); ++number) {
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        ++summary.commands;
+        auto start = Clock::now();
+        std::string result;
+        bool ok = true;
+        Args args;
+        try {
+            args = tokenize(line);
+            result = session.run(args);
+        }
+        catch(const std::exception& e) {
+            ok = false;
+            result = e.what();
+        }
+        double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        if (not ok)
+            ++summary.failed;
+        if (not args.empty())
+            timings[args[0]].push_back(micros);
+
+        char took[32];
+        std::snprintf(took, sizeof took, " (%.1f us)\n", micros);
+        out<<number<<": "<<(ok ? "ok " : "error ")<<result<<took;
+    }
+    summary.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    char row[128];
+    std::snprintf(row, sizeof row, "%-10s %10s %10s %10s %10s\n", "command", "count", "mean us", "p50 us", "p99 us");
+    report<<row;
+    for (auto& [command, samples] : timings) {
+        std::sort(samples.begin(), samples.end());
+        double total = 0;
+        for (auto sample : samples) {
+            total += sample;
+        }
+        std::snprintf(row, sizeof row, "%-10s %10zu %10.1f %10.1f %10.1f\n", command.c_str(), samples.size(),
+                      total / samples.size(), samples[samples.size() / 2], samples[samples.size() * 99 / 100]);
+        report<<row;
+    }
+    std::snprintf(row, sizeof row, "%zu commands, %zu failed, in %.3fs (%.0f commands/s)\n", summary.commands,
+                  summary.failed, summary.seconds, summary.seconds > 0 ? summary.commands / summary.seconds : 0.0);
+    report<<row;
+    return summary;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Librarydb.hpp"
+
+#include <cstddef> // size_t
+#include <istream> // istream
+#include <ostream> // ostream
+
+struct BatchSummary {
+    std::size_t commands = 0;
+    std::size_t failed = 0;
+    double seconds = 0;
+};
+
+// Runs commands against the database without a terminal, one per line:
+//     login USER PASSWORD        logout
+//     borrow BOOK_ID             return BOOK_ID
+//     like BOOK_ID               rate BOOK_ID STARS
+//     checkout [BOOK_ID...] [return BOOK_ID...]
+//     add-book TITLE AUTHOR QUANTITY [PUBLISHER [YEAR [EDITION [DESCRIPTION]]]]
+//     search TEXT...             find WORDS...
+//     stats
+// checkout returns and borrows a cart of books in one transaction. stats
+// reports the memory interning authors and publishers saves in the catalog
+// that search works on.
+// Arguments with spaces go in double quotes. Blank lines and lines starting
+// with # are skipped. Every command prints one result line with its time to
+// `out`; a latency table per command goes to `report` at the end.
+BatchSummary runBatch(Librarydb& db, std::istream& in, std::ostream& out, std::ostream& report);
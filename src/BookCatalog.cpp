@@ -0,0 +1,99 @@
+#include "BookCatalog.hpp"
+
+#include <algorithm> // stable_sort
+#include <memory> // make_shared
+#include <numeric> // iota
+#include <stdexcept> // length_error
+
+void PackedStrings::push_back(std::string_view text) {
+    if (buffer.size() + text.size() > UINT32_MAX)
+        throw std::length_error{"packed string column exceeds 4 GiB"};
+
+    spans.push_back({static_cast<std::uint32_t>(buffer.size()), static_cast<std::uint32_t>(text.size())});
+    buffer.append(text);
+}
+
+void PackedStrings::replace(std::size_t slot, std::string_view text) {
+    if (text.size() <= spans[slot].length) {
+        // Fits where the old text was
+        buffer.replace(spans[slot].offset, text.size(), text);
+        spans[slot].length = static_cast<std::uint32_t>(text.size());
+        return;
+    }
+    if (buffer.size() + text.size() > UINT32_MAX)
+        throw std::length_error{"packed string column exceeds 4 GiB"};
+
+    spans[slot] = {static_cast<std::uint32_t>(buffer.size()), static_cast<std::uint32_t>(text.size())};
+    buffer.append(text);
+}
+
+void PackedStrings::reserve(std::size_t count, std::size_t bytes) {
+    spans.reserve(count);
+    buffer.reserve(bytes);
+}
+
+BookCatalog::BookCatalog(const BookStack& books) {
+    reserve(books.size());
+    for (auto& book : books) {
+        push_back(*book);
+    }
+}
+
+void BookCatalog::reserve(std::size_t count) {
+    book_ids.reserve(count);
+    quantities.reserve(count);
+    pub_years.reserve(count);
+    editions.reserve(count);
+    ratings.reserve(count);
+    authors.reserve(count);
+    publishers.reserve(count);
+    // Rough per-book text sizes, to avoid most regrowth while loading
+    titles.reserve(count, count * 32);
+    descriptions.reserve(count, count * 64);
+}
+
+void BookCatalog::push_back(const Book& book) {
+    book_ids.push_back(book.book_id);
+    quantities.push_back(book.quantity);
+    pub_years.push_back(book.pub_year);
+    editions.push_back(book.edition);
+    ratings.push_back(book.rating);
+    titles.push_back(book.title);
+    authors.push_back(strings.intern(book.author));
+    publishers.push_back(strings.intern(book.publisher));
+    descriptions.push_back(book.description);
+}
+
+void BookCatalog::update(std::size_t slot, const Book& book) {
+    quantities[slot] = book.quantity;
+    pub_years[slot] = book.pub_year;
+    editions[slot] = book.edition;
+    ratings[slot] = book.rating;
+    titles.replace(slot, book.title);
+    authors[slot] = strings.intern(book.author);
+    publishers[slot] = strings.intern(book.publisher);
+    descriptions.replace(slot, book.description);
+}
+
+std::vector<std::uint32_t> BookCatalog::slotsByRating() const {
+    std::vector<std::uint32_t> slots(size());
+    std::iota(slots.begin(), slots.end(), 0);
+    std::stable_sort(slots.begin(), slots.end(), [this](std::uint32_t a, std::uint32_t b) {
+        return ratings[a] > ratings[b];
+    });
+    return slots;
+}
+
+BookPtr BookCatalog::Ref::toBook() const {
+    auto book = std::make_shared<Book>();
+    book->book_id = book_id();
+    book->title = title();
+    book->author = author();
+    book->quantity = quantity();
+    book->publisher = publisher();
+    book->pub_year = pub_year();
+    book->description = description();
+    book->edition = edition();
+    book->rating = rating();
+    return book;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Book.hpp"
+#include "StringPool.hpp"
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <string> // string
+#include <string_view> // string_view
+#include <vector> // vector
+
+// Strings of one field of every book, back to back in a single buffer
+class PackedStrings {
+    public:
+        void push_back(std::string_view text);
+        // Replacing appends the new text; the old bytes stay until the catalog is rebuilt
+        void replace(std::size_t slot, std::string_view text);
+        void reserve(std::size_t count, std::size_t bytes);
+
+        std::string_view operator[](std::size_t slot) const {
+            return {buffer.data() + spans[slot].offset, spans[slot].length};
+        }
+        std::size_t size() const { return spans.size(); }
+        std::size_t bytes() const { return buffer.size(); }
+
+    private:
+        struct Span {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        std::string buffer;
+        std::vector<Span> spans;
+};
+
+// The catalog laid out column by column, struct-of-arrays style. Numeric
+// fields sit in contiguous arrays and text in PackedStrings, so scanning
+// titles or sorting by rating reads only the memory of that one field.
+// Authors and publishers repeat across books, so they are interned in the
+// catalog's StringPool and each book keeps only their ids.
+class BookCatalog {
+    public:
+        // Handle to one book of the catalog, usable where a BookPtr was.
+        // Valid as long as the catalog is and the book is not moved.
+        class Ref {
+            public:
+                Ref(const BookCatalog& catalog, std::size_t slot) : catalog(&catalog), at(slot) {}
+
+                std::size_t slot() const { return at; }
+                std::size_t book_id() const { return catalog->book_ids[at]; }
+                std::string_view title() const { return catalog->titles[at]; }
+                std::string_view author() const { return catalog->strings[catalog->authors[at]]; }
+                int quantity() const { return catalog->quantities[at]; }
+                std::string_view publisher() const { return catalog->strings[catalog->publishers[at]]; }
+                int pub_year() const { return catalog->pub_years[at]; }
+                std::string_view description() const { return catalog->descriptions[at]; }
+                int edition() const { return catalog->editions[at]; }
+                double rating() const { return catalog->ratings[at]; }
+
+                // A standalone copy, for code that still takes a Book
+                BookPtr toBook() const;
+
+            private:
+                const BookCatalog* catalog;
+                std::size_t at;
+        };
+
+        BookCatalog() = default;
+        explicit BookCatalog(const BookStack& books);
+
+        void push_back(const Book& book);
+        void update(std::size_t slot, const Book& book);
+        void setQuantity(std::size_t slot, int quantity) { quantities[slot] = quantity; }
+        void setRating(std::size_t slot, double rating) { ratings[slot] = rating; }
+        void reserve(std::size_t count);
+
+        Ref operator[](std::size_t slot) const { return {*this, slot}; }
+        std::size_t size() const { return book_ids.size(); }
+        bool empty() const { return book_ids.empty(); }
+
+        // Columns, for scans that want a single field of every book
+        const std::vector<std::size_t>& bookIds() const { return book_ids; }
+        const PackedStrings& titleColumn() const { return titles; }
+        const std::vector<StringPool::Id>& authorColumn() const { return authors; }
+        const StringPool& internedStrings() const { return strings; }
+        const std::vector<int>& quantityColumn() const { return quantities; }
+        const std::vector<double>& ratingColumn() const { return ratings; }
+
+        // Slots ordered by rating, best first. Sorts 4 byte slots over the rating column
+        std::vector<std::uint32_t> slotsByRating() const;
+
+    private:
+        std::vector<std::size_t> book_ids;
+        std::vector<int> quantities;
+        std::vector<int> pub_years;
+        std::vector<int> editions;
+        std::vector<double> ratings;
+        std::vector<StringPool::Id> authors;
+        std::vector<StringPool::Id> publishers;
+        StringPool strings; // authors and publishers
+        PackedStrings titles;
+        PackedStrings descriptions;
+};
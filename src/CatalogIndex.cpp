@@ -0,0 +1,13 @@
+#include "CatalogIndex.hpp"
+
+CatalogIndex::CatalogIndex(const BookStack& books) {
+    slots.reserve(books.size());
+    for (std::size_t slot = 0; slot < books.size(); ++slot) {
+        slots.emplace(books[slot]->book_id, slot);
+    }
+}
+
+std::size_t CatalogIndex::slotOf(std::size_t book_id) const {
+    auto it = slots.find(book_id);
+    return it == slots.end() ? npos : it->second;
+}
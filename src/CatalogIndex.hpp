@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Book.hpp"
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <unordered_map> // unordered_map
+#include <vector> // vector
+
+// Slots of a BookStack by book id, so a book is found without scanning
+class CatalogIndex {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        explicit CatalogIndex(const BookStack& books);
+
+        // Slot of the book in the indexed BookStack, npos if it is not there
+        std::size_t slotOf(std::size_t book_id) const;
+        std::size_t size() const { return slots.size(); }
+
+    private:
+        std::unordered_map<std::size_t, std::size_t> slots;
+};
+
+// A set of catalog slots, one bit each. Used for what a user has borrowed or liked
+class SlotSet {
+    public:
+        explicit SlotSet(std::size_t slots) : words((slots + 63) / 64, 0) {}
+
+        void insert(std::size_t slot) { words[slot / 64] |= bit(slot); }
+        void erase(std::size_t slot) { words[slot / 64] &= ~bit(slot); }
+        bool contains(std::size_t slot) const {
+            return slot / 64 < words.size() && (words[slot / 64] & bit(slot)) != 0;
+        }
+
+    private:
+        static std::uint64_t bit(std::size_t slot) { return std::uint64_t{1} << (slot % 64); }
+
+        std::vector<std::uint64_t> words;
+};
@@ -0,0 +1,29 @@
+#include "Durability.hpp"
+
+#include <stdexcept> // invalid_argument
+
+const std::vector<DurabilityProfile>& durabilityProfiles() {
+    static const std::vector<DurabilityProfile> profiles{
+        {"safe", "DELETE", "FULL", 5'000, 1'000, false},
+        {"wal-balanced", "WAL", "NORMAL", 5'000, 1'000, true},
+        {"bulk-load", "WAL", "OFF", 30'000, 0, true},
+    };
+    return profiles;
+}
+
+const DurabilityProfile& durabilityProfile(std::string_view name) {
+    std::string known;
+    for (auto& profile : durabilityProfiles()) {
+        if (profile.name == name)
+            return profile;
+        known += known.empty() ? profile.name : ", " + profile.name;
+    }
+    throw std::invalid_argument{"unknown durability profile '" + std::string{name} + "' (known: " + known + ")"};
+}
+
+void applyDurability(SQLite::Database& databs, const DurabilityProfile& profile) {
+    databs.setBusyTimeout(profile.busy_timeout_ms);
+    databs.exec("PRAGMA journal_mode = " + profile.journal_mode);
+    databs.exec("PRAGMA synchronous = " + profile.synchronous);
+    databs.exec("PRAGMA wal_autocheckpoint = " + std::to_string(profile.wal_autocheckpoint));
+}
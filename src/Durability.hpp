@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SQLiteCpp/Database.h"
+
+#include <string> // string
+#include <string_view> // string_view
+#include <vector> // vector
+
+// How a connection trades durability for commit latency
+struct DurabilityProfile {
+    std::string name;
+    std::string journal_mode; // PRAGMA journal_mode
+    std::string synchronous;  // PRAGMA synchronous
+    int busy_timeout_ms;      // how long to wait on a locked database before failing
+    int wal_autocheckpoint;   // pages of WAL before an automatic checkpoint, 0 for none
+    bool checkpoint_on_close; // fold the WAL back into the database file on close
+};
+
+// safe:         rollback journal, fsync on every commit. Survives power loss.
+// wal-balanced: WAL, fsync only at checkpoints. A power loss may drop the last
+//               commits but never corrupts the database; readers don't block the writer.
+// bulk-load:    WAL, no fsync and no automatic checkpoints. For imports that
+//               can be rerun; the WAL is checkpointed once on close.
+const std::vector<DurabilityProfile>& durabilityProfiles();
+
+// Throws std::invalid_argument for unknown names
+const DurabilityProfile& durabilityProfile(std::string_view name);
+
+void applyDurability(SQLite::Database& databs, const DurabilityProfile& profile);
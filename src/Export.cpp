@@ -0,0 +1,234 @@
+#include "Export.hpp"
+
+#include "SQLiteCpp/Database.h"
+#include "SQLiteCpp/Statement.h"
+
+#include <algorithm> // min
+#include <array> // array
+#include <atomic> // atomic
+#include <charconv> // to_chars
+#include <chrono> // steady_clock
+#include <cstdint> // int64_t
+#include <exception> // exception_ptr, current_exception, rethrow_exception
+#include <fstream> // ofstream
+#include <stdexcept> // runtime_error
+#include <string_view> // string_view
+#include <thread> // thread
+
+namespace {
+    struct TableQuery {
+        const char* table;
+        const char* query;
+    };
+
+    const std::array<TableQuery, 4> exported_tables{{
+        {"books", R"#(
+            SELECT [book_id], [title], [author], [quantity], [publisher],
+                   [pub_year], [description], [edition], [rating], [raters]
+                FROM [books] ORDER BY [book_id]
+        )#"},
+        {"users", "SELECT [username], [email], [type] FROM [users] ORDER BY [username]"},
+        {"borrows", "SELECT [username], [book_id] FROM [borrows] ORDER BY [username], [book_id]"},
+        {"favourites", "SELECT [username], [book_id] FROM [favourites] ORDER BY [username], [book_id]"},
+    }};
+
+    // Gives up on a table if a writer holds it locked for longer than this
+    constexpr int busy_timeout_ms = 10'000;
+
+    // Output file behind a buffer of fixed size, written out whenever it fills up
+    class BufferedWriter {
+        public:
+            explicit BufferedWriter(const std::filesystem::path& file) : out(file, std::ios::binary) {
+                if (not out)
+                    throw std::runtime_error{"can't create " + file.string()};
+            }
+
+            void put(char c) {
+                if (used == buffer.size())
+                    flush();
+                buffer[used++] = c;
+            }
+
+            void put(std::string_view text) {
+                while (not text.empty()) {
+                    if (used == buffer.size())
+                        flush();
+                    auto n = std::min(text.size(), buffer.size() - used);
+                    text.copy(buffer.data() + used, n);
+                    used += n;
+                    text.remove_prefix(n);
+                }
+            }
+
+            template<class Number>
+            void putNumber(Number value) {
+                std::array<char, 32> digits;
+                auto end = std::to_chars(digits.begin(), digits.end(), value).ptr;
+                put(std::string_view{digits.data(), static_cast<std::size_t>(end - digits.data())});
+            }
+
+            void flush() {
+                out.write(buffer.data(), static_cast<std::streamsize>(used));
+                used = 0;
+                if (not out)
+                    throw std::runtime_error{"write failed"};
+            }
+
+            void close() {
+                flush();
+                out.close();
+                if (not out)
+                    throw std::runtime_error{"write failed"};
+            }
+
+        private:
+            std::ofstream out;
+            std::array<char, 64 * 1024> buffer;
+            std::size_t used = 0;
+    };
+
+    std::string_view textOf(const SQLite::Column& column) {
+        return {column.getText(), static_cast<std::size_t>(column.getBytes())};
+    }
+
+    void putCsvText(BufferedWriter& out, std::string_view text) {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out.put(text);
+            return;
+        }
+        out.put('"');
+        for (char c : text) {
+            if (c == '"')
+                out.put('"');
+            out.put(c);
+        }
+        out.put('"');
+    }
+
+    void putJsonText(BufferedWriter& out, std::string_view text) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out.put('"');
+        for (char c : text) {
+            switch (c) {
+                case '"': out.put("\\\""); break;
+                case '\\': out.put("\\\\"); break;
+                case '\n': out.put("\\n"); break;
+                case '\r': out.put("\\r"); break;
+                case '\t': out.put("\\t"); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out.put("\\u00");
+                        out.put(hex[c >> 4]);
+                        out.put(hex[c & 0xF]);
+                    }
+                    else {
+                        out.put(c);
+                    }
+            }
+        }
+        out.put('"');
+    }
+
+    void putValue(BufferedWriter& out, const SQLite::Column& column, ExportFormat format) {
+        if (column.isNull()) {
+            if (format == ExportFormat::JSON_LINES)
+                out.put("null");
+        }
+        else if (column.isInteger()) {
+            out.putNumber(column.getInt64());
+        }
+        else if (column.isFloat()) {
+            out.putNumber(column.getDouble());
+        }
+        else if (format == ExportFormat::CSV) {
+            putCsvText(out, textOf(column));
+        }
+        else {
+            putJsonText(out, textOf(column));
+        }
+    }
+
+    ExportedTable exportTable(const std::string& db_path, const TableQuery& table,
+                              const std::filesystem::path& dir, ExportFormat format) {
+        auto started = std::chrono::steady_clock::now();
+        ExportedTable result;
+        result.table = table.table;
+        result.file = dir / (result.table + (format == ExportFormat::CSV ? ".csv" : ".jsonl"));
+
+        SQLite::Database databs(db_path, SQLite::OPEN_READONLY, busy_timeout_ms);
+        SQLite::Statement stmnt(databs, table.query);
+        const int columns = stmnt.getColumnCount();
+
+        // Written next to the target and renamed at the end, so a failed run
+        // never leaves a truncated dump behind under the real name
+        auto partial = result.file;
+        partial += ".part";
+        BufferedWriter out(partial);
+
+        if (format == ExportFormat::CSV) {
+            for (int i = 0; i < columns; ++i) {
+                if (i > 0)
+                    out.put(',');
+                putCsvText(out, stmnt.getColumnName(i));
+            }
+            out.put('\n');
+        }
+
+        while (stmnt.executeStep()) {
+            for (int i = 0; i < columns; ++i) {
+                if (format == ExportFormat::CSV) {
+                    if (i > 0)
+                        out.put(',');
+                }
+                else {
+                    out.put(i == 0 ? '{' : ',');
+                    putJsonText(out, stmnt.getColumnName(i));
+                    out.put(':');
+                }
+                putValue(out, stmnt.getColumn(i), format);
+            }
+            out.put(format == ExportFormat::CSV ? "\n" : "}\n");
+            ++result.rows;
+        }
+
+        out.close();
+        std::filesystem::rename(partial, result.file);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return result;
+    }
+}
+
+std::vector<ExportedTable> exportTables(const std::string& db_path, const std::filesystem::path& dir,
+                                        ExportFormat format, unsigned jobs) {
+    std::filesystem::create_directories(dir);
+
+    std::vector<ExportedTable> results(exported_tables.size());
+    std::vector<std::exception_ptr> errors(exported_tables.size());
+    std::atomic<std::size_t> next_table = 0;
+
+    auto worker = [&] {
+        for (auto t = next_table++; t < exported_tables.size(); t = next_table++) {
+            try {
+                results[t] = exportTable(db_path, exported_tables[t], dir, format);
+            }
+            catch(...) {
+                errors[t] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned j = 1; j < std::min<std::size_t>(std::max(jobs, 1u), exported_tables.size()); ++j) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    for (auto& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+    return results;
+}
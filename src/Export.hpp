@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <filesystem> // path
+#include <string> // string
+#include <vector> // vector
+
+enum class ExportFormat { CSV, JSON_LINES };
+
+struct ExportedTable {
+    std::string table;
+    std::filesystem::path file;
+    std::size_t rows = 0;
+    double seconds = 0;
+};
+
+// Dumps the books, users (without passwords), borrows and favourites tables of
+// the database at db_path into dir, as <table>.csv or <table>.jsonl.
+// Every table is read on its own read-only connection and rows are streamed
+// through a fixed size write buffer, so memory use doesn't grow with the data.
+// Up to `jobs` tables are exported at once; each one is a consistent snapshot
+// of its table, but the tables may be taken at slightly different moments.
+std::vector<ExportedTable> exportTables(const std::string& db_path, const std::filesystem::path& dir,
+                                        ExportFormat format, unsigned jobs = 4);
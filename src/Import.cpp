@@ -0,0 +1,454 @@
+#include "Import.hpp"
+#include "Book.hpp"
+#include "Librarydb.hpp"
+
+#include "SQLiteCpp/Exception.h"
+
+#include <array> // array
+#include <charconv> // from_chars
+#include <chrono> // steady_clock
+#include <cstddef> // size_t
+#include <fstream> // ifstream
+#include <optional> // optional
+#include <stdexcept> // invalid_argument, runtime_error
+#include <string> // string, getline
+#include <string_view> // string_view
+#include <vector> // vector
+
+namespace {
+    enum Field { BOOK_ID, TITLE, AUTHOR, QUANTITY, PUBLISHER, PUB_YEAR, DESCRIPTION, EDITION, RATING, RATERS, FIELD_COUNT };
+
+    // Values of one record, by field. Empty when the record doesn't have it
+    using Fields = std::array<std::optional<std::string>, FIELD_COUNT>;
+
+    // Only this many errors are kept with their messages. All of them are counted
+    constexpr std::size_t max_kept_errors = 1000;
+
+    std::optional<Field> fieldNamed(std::string_view name) {
+        static const std::array<std::string_view, FIELD_COUNT> names{
+            "book_id", "title", "author", "quantity", "publisher", "pub_year", "description", "edition", "rating", "raters"
+        };
+        for (std::size_t f = 0; f < names.size(); ++f) {
+            if (names[f] == name)
+                return static_cast<Field>(f);
+        }
+        return std::nullopt;
+    }
+
+    template<class Number>
+    Number parseNumber(const std::string& text, const char* name) {
+        Number value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc{} || end != text.data() + text.size())
+            throw std::invalid_argument{std::string{"invalid "} + name + " '" + text + "'"};
+        return value;
+    }
+
+    bool present(const Fields& fields, Field f) {
+        return fields[f] && not fields[f]->empty();
+    }
+
+    // Fills book from a record. Returns whether the record carries its own book_id
+    bool toBook(Fields& fields, Book& book) {
+        for (auto [f, name] : {std::pair{TITLE, "title"}, std::pair{AUTHOR, "author"}, std::pair{QUANTITY, "quantity"}}) {
+            if (not present(fields, f))
+                throw std::invalid_argument{std::string{"missing "} + name};
+        }
+
+        book.title = std::move(*fields[TITLE]);
+        book.author = std::move(*fields[AUTHOR]);
+        book.quantity = parseNumber<int>(*fields[QUANTITY], "quantity");
+        book.publisher = present(fields, PUBLISHER) ? std::move(*fields[PUBLISHER]) : std::string{};
+        book.pub_year = present(fields, PUB_YEAR) ? parseNumber<int>(*fields[PUB_YEAR], "pub_year") : -1;
+        book.description = present(fields, DESCRIPTION) ? std::move(*fields[DESCRIPTION]) : std::string{};
+        book.edition = present(fields, EDITION) ? parseNumber<int>(*fields[EDITION], "edition") : -1;
+        book.rating = present(fields, RATING) ? parseNumber<double>(*fields[RATING], "rating") : 0.0;
+
+        if (not present(fields, BOOK_ID))
+            return false;
+        book.book_id = static_cast<std::size_t>(parseNumber<long long>(*fields[BOOK_ID], "book_id"));
+        return true;
+    }
+
+    // How many votes the record's rating is the average of
+    int ratersOf(const Fields& fields) {
+        return present(fields, RATERS) ? parseNumber<int>(*fields[RATERS], "raters") : 1;
+    }
+
+    // RFC 4180 records: comma separated, optionally double quoted fields, which
+    // may hold commas, doubled quotes and line breaks. Blank lines are skipped.
+    class CsvReader {
+        public:
+            explicit CsvReader(std::istream& in) : in(*in.rdbuf()) {}
+
+            // Reads the next record into values. False at the end of the input
+            bool next(std::vector<std::string>& values);
+            // Line the last record started on
+            std::size_t line() const { return record_line; }
+
+        private:
+            std::streambuf& in;
+            std::size_t current_line = 1;
+            std::size_t record_line = 0;
+    };
+
+    bool CsvReader::next(std::vector<std::string>& values) {
+        using traits = std::char_traits<char>;
+
+        std::size_t count = 0;
+        auto startValue = [&] {
+            if (count == values.size())
+                values.emplace_back();
+            values[count++].clear();
+        };
+
+        bool quoted = false;
+        bool blank = true;
+        record_line = current_line;
+        startValue();
+        for (;;) {
+            int c = in.sbumpc();
+            if (c == traits::eof()) {
+                if (quoted)
+                    throw std::invalid_argument{"unterminated quoted field"};
+                values.resize(count);
+                return not blank;
+            }
+
+            char ch = traits::to_char_type(c);
+            if (quoted) {
+                if (ch == '"' && in.sgetc() == '"') {
+                    in.sbumpc();
+                    values[count - 1] += '"';
+                }
+                else if (ch == '"') {
+                    quoted = false;
+                }
+                else {
+                    current_line += ch == '\n';
+                    values[count - 1] += ch;
+                }
+                continue;
+            }
+
+            switch (ch) {
+                case '"':
+                    quoted = true;
+                    blank = false;
+                    break;
+                case ',':
+                    startValue();
+                    blank = false;
+                    break;
+                case '\r':
+                    break;
+                case '\n':
+                    ++current_line;
+                    if (not blank) {
+                        values.resize(count);
+                        return true;
+                    }
+                    record_line = current_line;
+                    break;
+                default:
+                    values[count - 1] += ch;
+                    blank = false;
+            }
+        }
+    }
+
+    // Parser for one flat JSON object per line. Strings, numbers, booleans and
+    // null are accepted as values; nested objects and arrays are not.
+    class JsonLine {
+        public:
+            explicit JsonLine(std::string_view text) : text(text) {}
+
+            void parse(Fields& fields);
+
+        private:
+            void skipSpace() {
+                while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r'))
+                    ++pos;
+            }
+
+            void expect(char c) {
+                skipSpace();
+                if (pos >= text.size() || text[pos] != c)
+                    throw std::invalid_argument{std::string{"expected '"} + c + "' at column " + std::to_string(pos + 1)};
+                ++pos;
+            }
+
+            std::string parseString();
+            std::optional<std::string> parseValue();
+            void appendUtf8(std::string& out, unsigned codepoint);
+            unsigned parseHex4();
+
+            std::string_view text;
+            std::size_t pos = 0;
+    };
+
+    void JsonLine::parse(Fields& fields) {
+        expect('{');
+        skipSpace();
+        if (pos < text.size() && text[pos] == '}') {
+            ++pos;
+            return;
+        }
+        for (;;) {
+            skipSpace();
+            auto key = parseString();
+            expect(':');
+            auto value = parseValue();
+            if (auto field = fieldNamed(key))
+                fields[*field] = std::move(value);
+
+            skipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            expect('}');
+            break;
+        }
+        skipSpace();
+        if (pos != text.size())
+            throw std::invalid_argument{"trailing characters after object"};
+    }
+
+    std::optional<std::string> JsonLine::parseValue() {
+        skipSpace();
+        if (pos >= text.size())
+            throw std::invalid_argument{"missing value"};
+
+        char c = text[pos];
+        if (c == '"')
+            return parseString();
+        if (c == '{' || c == '[')
+            throw std::invalid_argument{"nested values are not supported"};
+
+        // Number or literal: everything up to the next delimiter
+        auto start = pos;
+        while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ' ' && text[pos] != '\t')
+            ++pos;
+        auto token = text.substr(start, pos - start);
+        if (token == "null")
+            return std::nullopt;
+        if (token == "true")
+            return "1";
+        if (token == "false")
+            return "0";
+        if (token.empty() || token.find_first_not_of("+-0123456789.eE") != std::string_view::npos)
+            throw std::invalid_argument{"invalid value '" + std::string{token} + "'"};
+        return std::string{token};
+    }
+
+    std::string JsonLine::parseString() {
+        expect('"');
+        std::string out;
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"')
+                return out;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size())
+                break;
+            switch (text[pos++]) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned codepoint = parseHex4();
+                    // A surrogate pair encodes one codepoint beyond the basic plane
+                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF && text.substr(pos, 2) == "\\u") {
+                        pos += 2;
+                        unsigned low = parseHex4();
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    throw std::invalid_argument{"invalid escape in string"};
+            }
+        }
+        throw std::invalid_argument{"unterminated string"};
+    }
+
+    unsigned JsonLine::parseHex4() {
+        if (pos + 4 > text.size())
+            throw std::invalid_argument{"truncated \\u escape"};
+        unsigned value = 0;
+        auto [end, error] = std::from_chars(text.data() + pos, text.data() + pos + 4, value, 16);
+        if (error != std::errc{} || end != text.data() + pos + 4)
+            throw std::invalid_argument{"invalid \\u escape"};
+        pos += 4;
+        return value;
+    }
+
+    void JsonLine::appendUtf8(std::string& out, unsigned codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        }
+        else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool isJsonLines(const std::filesystem::path& file) {
+        auto extension = file.extension();
+        return extension == ".jsonl" || extension == ".ndjson" || extension == ".json";
+    }
+
+    // Counts rows and errors, and reports progress about once a second
+    class Progress {
+        public:
+            Progress(ImportSummary& summary, std::ostream& out) : summary(summary), out(out) {}
+
+            void imported() {
+                ++summary.imported;
+                tick();
+            }
+
+            void failed(std::size_t line, std::string message) {
+                ++summary.failed;
+                if (summary.errors.size() < max_kept_errors)
+                    summary.errors.push_back({line, std::move(message)});
+                tick();
+            }
+
+            void done() {
+                summary.seconds = elapsed();
+                report();
+                out<<'\n';
+            }
+
+        private:
+            double elapsed() const {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            void tick() {
+                // Only look at the clock every few thousand rows
+                if ((++rows & 0xFFF) != 0)
+                    return;
+                auto now = elapsed();
+                if (now - last_report >= 1.0) {
+                    last_report = now;
+                    report();
+                }
+            }
+
+            void report() {
+                auto seconds = elapsed();
+                out<<"\r"<<summary.imported<<" books imported, "<<summary.failed<<" rejected";
+                if (seconds > 0)
+                    out<<", "<<static_cast<std::size_t>(summary.imported / seconds)<<" books/s";
+                out<<std::flush;
+            }
+
+            ImportSummary& summary;
+            std::ostream& out;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            double last_report = 0;
+            std::size_t rows = 0;
+    };
+}
+
+ImportSummary importBooks(Librarydb& db, const std::filesystem::path& file, std::ostream& out, std::size_t batch_size) {
+    std::ifstream in(file, std::ios::binary);
+    if (not in)
+        throw std::runtime_error{"can't open " + file.string()};
+
+    ImportSummary summary;
+    Progress progress{summary, out};
+    auto import = db.importBooks(batch_size);
+
+    Fields fields;
+    Book book;
+    auto store = [&](std::size_t line) {
+        try {
+            bool keep_id = toBook(fields, book);
+            import.add(book, keep_id, ratersOf(fields));
+            progress.imported();
+        }
+        catch(const std::invalid_argument& e) {
+            progress.failed(line, e.what());
+        }
+        catch(const SQLite::Exception& e) {
+            // Constraint and type errors only reject the row. Anything else stops the import
+            if (e.getErrorCode() != SQLITE_CONSTRAINT && e.getErrorCode() != SQLITE_MISMATCH)
+                throw;
+            progress.failed(line, e.what());
+        }
+    };
+
+    if (isJsonLines(file)) {
+        std::string line;
+        for (std::size_t number = 1; std::getline(in, line); ++number) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            fields = {};
+            try {
+                JsonLine{line}.parse(fields);
+            }
+            catch(const std::invalid_argument& e) {
+                progress.failed(number, e.what());
+                continue;
+            }
+            store(number);
+        }
+    }
+    else {
+        CsvReader csv{in};
+        std::vector<std::string> values;
+        if (not csv.next(values))
+            throw std::runtime_error{file.string() + " is empty"};
+
+        // The header row says which value goes to which field
+        std::vector<std::optional<Field>> columns;
+        for (auto& name : values) {
+            columns.push_back(fieldNamed(name));
+        }
+
+        for (;;) {
+            try {
+                if (not csv.next(values))
+                    break;
+            }
+            catch(const std::invalid_argument& e) {
+                progress.failed(csv.line(), e.what());
+                break;
+            }
+            fields = {};
+            for (std::size_t i = 0; i < values.size() && i < columns.size(); ++i) {
+                if (columns[i])
+                    fields[*columns[i]] = std::move(values[i]);
+            }
+            store(csv.line());
+        }
+    }
+
+    import.finish();
+    progress.done();
+    return summary;
+}
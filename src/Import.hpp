@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Librarydb.hpp"
+
+#include <cstddef> // size_t
+#include <filesystem> // path
+#include <ostream> // ostream
+#include <string> // string
+#include <vector> // vector
+
+// A record of the import file that did not make it into the database
+struct ImportError {
+    std::size_t line;
+    std::string message;
+};
+
+struct ImportSummary {
+    std::size_t imported = 0;
+    std::size_t failed = 0;
+    std::vector<ImportError> errors; // the first thousand of them
+    double seconds = 0;
+};
+
+// Streams books from a file into the books table. CSV files need a header row
+// naming their columns; .jsonl/.ndjson files hold one flat JSON object per line.
+// Known columns are book_id, title, author, quantity, publisher, pub_year,
+// description, edition, rating and raters; title, author and quantity are required.
+// A rating without raters counts as a single vote.
+// Books without a book_id get one from the database. Progress goes to `progress`.
+ImportSummary importBooks(Librarydb& db, const std::filesystem::path& file, std::ostream& progress,
+                          std::size_t batch_size = 20'000);
@@ -1,17 +1,26 @@
 #include "Librarydb.hpp"
 #include "Book.hpp"
+#include "Metrics.hpp"
+#include "StatementCache.hpp"
 #include "User.hpp"
 
 #include "SQLiteCpp/Exception.h"
 #include "SQLiteCpp/Statement.h"
 #include "SQLiteCpp/Transaction.h"
 
+#include <algorithm> // max
+#include <array> // array
 #include <cstddef> // size_t
 #include <cstdint> // int64_t
 #include <memory> // make_shared
-#include <stdexcept> // invalid_argument
-#include <string> // string
+#include <mutex> // lock_guard, unique_lock
+#include <optional> // optional
+#include <shared_mutex> // shared_lock
+#include <stdexcept> // invalid_argument, runtime_error
+#include <string> // string, to_string
+#include <thread> // this_thread
 #include <utility> // static_cast
+#include <vector> // vector
 
 // forward declarations
 
@@ -20,11 +29,77 @@ void Librarydb::init() {
         throw std::invalid_argument{"empty database filename"};
     }
     databs = std::make_unique<SQLite::Database>(db_path, SQLite::OPEN_READWRITE);
+    statements = std::make_unique<StatementCache>(*databs);
+    applyDurability(*databs, durability);
     if(not databs->tableExists("users"))
         makeSchema();
+    // Still without foreign key enforcement, which rebuilding a table needs
+    migrate();
     databs->exec("PRAGMA foreign_keys = ON");
 }
 
+Librarydb::ReadConnection::ReadConnection(const std::string& db_path, int busy_timeout_ms)
+    : databs(db_path, SQLite::OPEN_READONLY, busy_timeout_ms), statements(databs) {}
+
+// The pools a thread holds a read connection in. Its connections are closed
+// when it exits, so short-lived threads don't leave theirs open and a later
+// thread given the same id opens its own
+struct Librarydb::ThreadReaders {
+    std::vector<std::weak_ptr<ReaderPool>> pools;
+
+    ~ThreadReaders() {
+        auto id = std::this_thread::get_id();
+        for(auto& held : pools) {
+            auto pool = held.lock();
+            if(not pool)
+                continue;
+            // Closed once the lock is released, so other threads aren't kept waiting on it
+            decltype(pool->readers)::node_type connection;
+            std::unique_lock<std::shared_mutex> lock(pool->mtx);
+            connection = pool->readers.extract(id);
+        }
+    }
+};
+
+StatementCache& Librarydb::reader() {
+    auto id = std::this_thread::get_id();
+    {
+        std::shared_lock<std::shared_mutex> lock(read_pool->mtx);
+        if(auto it = read_pool->readers.find(id); it != read_pool->readers.end())
+            return it->second->statements;
+    }
+
+    // Only this thread adds its own entry, so nobody can have raced us to it
+    auto connection = std::make_unique<ReadConnection>(db_path, durability.busy_timeout_ms);
+    auto& cache = connection->statements;
+    {
+        std::unique_lock<std::shared_mutex> lock(read_pool->mtx);
+        read_pool->readers[id] = std::move(connection);
+    }
+
+    thread_local ThreadReaders held;
+    std::erase_if(held.pools, [](const std::weak_ptr<ReaderPool>& pool) { return pool.expired(); });
+    held.pools.push_back(read_pool);
+    return cache;
+}
+
+Librarydb::~Librarydb() {
+    {
+        // Threads still running find nothing of theirs left to close when they exit
+        std::unique_lock<std::shared_mutex> lock(read_pool->mtx);
+        read_pool->readers.clear();
+    }
+    if(not durability.checkpoint_on_close)
+        return;
+    statements.reset();
+    try {
+        databs->exec("PRAGMA wal_checkpoint(TRUNCATE)");
+    }
+    catch(const SQLite::Exception&) {
+        // Best effort: whatever is left in the WAL is checkpointed by the next connection
+    }
+}
+
 void Librarydb::makeSchema(){
     // Create users table
     SQLite::Transaction trxn(*databs);
@@ -97,31 +172,7 @@ void Librarydb::makeSchema(){
                         ON DELETE CASCADE
                  )
                  )#");
-        databs->exec(R"#(
-                CREATE TRIGGER decrease_book_number
-                     AFTER INSERT ON [borrows]
-                BEGIN
-                    UPDATE [books] SET quantity = quantity - 1
-                        WHERE book_id = NEW.book_id;
-                END
-                )#");
-        databs->exec(R"#(
-                CREATE TRIGGER increase_book_number
-                     AFTER DELETE ON [borrows]
-                BEGIN
-                    UPDATE [books] SET quantity = quantity + 1
-                        WHERE book_id = OLD.book_id;
-                END
-                )#");
-        databs->exec(R"#(
-                CREATE TRIGGER remove_admin_borrows
-                     AFTER UPDATE ON [users]
-                WHEN NEW.type = 'Admin' AND OLD.type = 'Regular'
-                BEGIN
-                     DELETE FROM [borrows]
-                        WHERE username = NEW.username;
-                END
-                )#");
+        makeBorrowTriggers();
         trxn.commit();
     }
     catch(SQLite::Exception& e) {
@@ -130,17 +181,229 @@ void Librarydb::makeSchema(){
     }
 }
 
+// Keeps book quantities in step with borrows, and takes admins' borrows away
+void Librarydb::makeBorrowTriggers() {
+    databs->exec(R"#(
+            CREATE TRIGGER decrease_book_number
+                 AFTER INSERT ON [borrows]
+            BEGIN
+                UPDATE [books] SET quantity = quantity - 1
+                    WHERE book_id = NEW.book_id;
+            END
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER increase_book_number
+                 AFTER DELETE ON [borrows]
+            BEGIN
+                UPDATE [books] SET quantity = quantity + 1
+                    WHERE book_id = OLD.book_id;
+            END
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER remove_admin_borrows
+                 AFTER UPDATE ON [users]
+            WHEN NEW.type = 'Admin' AND OLD.type = 'Regular'
+            BEGIN
+                 DELETE FROM [borrows]
+                    WHERE username = NEW.username;
+            END
+            )#");
+}
+
+// Brings the schema made by makeSchema() up to date. PRAGMA user_version
+// counts the migrations a database has had; each one runs in its own
+// transaction together with the bump of that count, so a crash in between
+// leaves the database at the version before it and the migration runs again.
+// New schema changes go at the end of the list, never in between.
+void Librarydb::migrate() {
+    struct Migration {
+        const char* description;
+        void (Librarydb::*apply)();
+    };
+    const std::array<Migration, 3> migrations{{
+        {"full-text index of books", &Librarydb::makeSearchIndex},
+        {"relation tables without rowid, indexed by book", &Librarydb::rebuildRelationTables},
+        {"one rating per user and book", &Librarydb::makeRatings},
+    }};
+
+    auto version = databs->execAndGet("PRAGMA user_version").getInt();
+    if(version > static_cast<int>(migrations.size()))
+        throw std::runtime_error{"database schema version " + std::to_string(version) + " is newer than this program"};
+
+    for(; version < static_cast<int>(migrations.size()); ++version) {
+        SQLite::Transaction trxn(*databs);
+        (this->*migrations[version].apply)();
+        databs->exec("PRAGMA user_version = " + std::to_string(version + 1));
+        trxn.commit();
+    }
+}
+
+// Full-text index of the books, kept up to date by triggers. It stores no text
+// of its own and reads it back from [books] when needed
+void Librarydb::makeSearchIndex() {
+    // Databases of the release that brought it in made it without a version
+    if(databs->tableExists("books_fts"))
+        return;
+    databs->exec(R"#(
+            CREATE VIRTUAL TABLE [books_fts] USING fts5 (
+                [title], [author], [description],
+                content = 'books', content_rowid = 'book_id',
+                tokenize = 'unicode61 remove_diacritics 2'
+            )
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER books_fts_insert
+                 AFTER INSERT ON [books]
+            BEGIN
+                INSERT INTO [books_fts] (rowid, [title], [author], [description])
+                    VALUES (NEW.book_id, NEW.title, NEW.author, NEW.description);
+            END
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER books_fts_delete
+                 AFTER DELETE ON [books]
+            BEGIN
+                INSERT INTO [books_fts] ([books_fts], rowid, [title], [author], [description])
+                    VALUES ('delete', OLD.book_id, OLD.title, OLD.author, OLD.description);
+            END
+            )#");
+    // Not on quantity or rating changes, which are most updates
+    databs->exec(R"#(
+            CREATE TRIGGER books_fts_update
+                 AFTER UPDATE OF [book_id], [title], [author], [description] ON [books]
+            BEGIN
+                INSERT INTO [books_fts] ([books_fts], rowid, [title], [author], [description])
+                    VALUES ('delete', OLD.book_id, OLD.title, OLD.author, OLD.description);
+                INSERT INTO [books_fts] (rowid, [title], [author], [description])
+                    VALUES (NEW.book_id, NEW.title, NEW.author, NEW.description);
+            END
+            )#");
+    // Index the books already there
+    databs->exec("INSERT INTO [books_fts] ([books_fts]) VALUES ('rebuild')");
+}
+
+// Favourites and borrows become WITHOUT ROWID tables, clustered on their
+// (username, book_id) key, so a user's rows are read in one range without a
+// second lookup. Each also gets an index by book, which the ON DELETE CASCADE
+// of removing a book and lookups of a book's readers use instead of scanning
+// the whole table. It holds the username too, so those never touch the table.
+void Librarydb::rebuildRelationTables() {
+    // Dropped with the tables, or naming them; made again once the tables are back
+    databs->exec("DROP TRIGGER IF EXISTS [remove_admin_borrows]");
+
+    databs->exec(R"#(
+             CREATE TABLE [favourites_new]
+             (
+                [username] VARCHAR(50) NOT NULL,
+                [book_id] INTEGER NOT NULL,
+                CONSTRAINT [pk_favourites] PRIMARY KEY (username, book_id),
+                FOREIGN KEY ([username]) REFERENCES [users] (username)
+                    ON DELETE CASCADE,
+                FOREIGN KEY (book_id) REFERENCES [books] (book_id)
+                    ON DELETE CASCADE
+             ) WITHOUT ROWID
+             )#");
+    databs->exec(R"#(
+             CREATE TABLE [borrows_new]
+             (
+                [username] VARCHAR(50) NOT NULL,
+                [book_id] INTEGER NOT NULL,
+                CONSTRAINT [pk_borrows] PRIMARY KEY (username, book_id),
+                FOREIGN KEY (username) REFERENCES [users] (username)
+                    ON DELETE CASCADE,
+                FOREIGN KEY (book_id) REFERENCES [books] (book_id)
+                    ON DELETE CASCADE
+             ) WITHOUT ROWID
+             )#");
+    for(std::string table : {"favourites", "borrows"}) {
+        databs->exec("INSERT INTO [" + table + "_new] (username, book_id) SELECT username, book_id FROM [" + table + "]");
+        databs->exec("DROP TABLE [" + table + "]");
+        databs->exec("ALTER TABLE [" + table + "_new] RENAME TO [" + table + "]");
+        databs->exec("CREATE INDEX [" + table + "_by_book] ON [" + table + "] (book_id, username)");
+    }
+
+    makeBorrowTriggers();
+}
+
+// Every user's own rating of a book, which rating again replaces. Triggers
+// keep the sum and count of a book's ratings on the book, so its average is
+// always up to date without a read-modify-write from here.
+// Ratings made before this are kept in the totals, as votes of nobody; the
+// total is REAL so that their averages carry over exactly.
+// Safe to run again over a database it has already been run on.
+void Librarydb::makeRatings() {
+    if (databs->execAndGet("SELECT count(*) FROM pragma_table_info('books') WHERE name = 'rating_total'").getInt() == 0) {
+        databs->exec("ALTER TABLE [books] ADD COLUMN [rating_total] REAL NOT NULL DEFAULT 0");
+        databs->exec(R"#(
+                 UPDATE [books] SET
+                    [raters] = coalesce(raters, 0),
+                    [rating_total] = coalesce(rating, 0) * coalesce(raters, 0)
+                 )#");
+    }
+    databs->exec(R"#(
+             CREATE TABLE IF NOT EXISTS [ratings]
+             (
+                [username] VARCHAR(50) NOT NULL,
+                [book_id] INTEGER NOT NULL,
+                [stars] INTEGER NOT NULL CHECK (stars BETWEEN 1 AND 5),
+                CONSTRAINT [pk_ratings] PRIMARY KEY (username, book_id),
+                FOREIGN KEY (username) REFERENCES [users] (username)
+                    ON DELETE CASCADE,
+                FOREIGN KEY (book_id) REFERENCES [books] (book_id)
+                    ON DELETE CASCADE
+             ) WITHOUT ROWID
+             )#");
+    databs->exec("CREATE INDEX IF NOT EXISTS [ratings_by_book] ON [ratings] (book_id, username)");
+    // The right hand sides of SET see the row as it was before the update
+    databs->exec(R"#(
+            CREATE TRIGGER IF NOT EXISTS rating_added
+                 AFTER INSERT ON [ratings]
+            BEGIN
+                UPDATE [books] SET
+                    raters = raters + 1,
+                    rating_total = rating_total + NEW.stars,
+                    rating = (rating_total + NEW.stars) / (raters + 1)
+                WHERE book_id = NEW.book_id;
+            END
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER IF NOT EXISTS rating_changed
+                 AFTER UPDATE OF [stars] ON [ratings]
+            BEGIN
+                UPDATE [books] SET
+                    rating_total = rating_total + NEW.stars - OLD.stars,
+                    rating = (rating_total + NEW.stars - OLD.stars) / raters
+                WHERE book_id = NEW.book_id;
+            END
+            )#");
+    databs->exec(R"#(
+            CREATE TRIGGER IF NOT EXISTS rating_removed
+                 AFTER DELETE ON [ratings]
+            BEGIN
+                UPDATE [books] SET
+                    raters = raters - 1,
+                    rating_total = rating_total - OLD.stars,
+                    rating = CASE WHEN raters > 1
+                        THEN (rating_total - OLD.stars) / (raters - 1)
+                        ELSE 0 END
+                WHERE book_id = OLD.book_id;
+            END
+            )#");
+}
+
 UserPtr Librarydb::restoreSession(std::size_t session){
+    static auto& metric = metrics().operation("restoreSession");
+    ScopedTimer timed(metric);
     auto query = R"#(
         SELECT [users].[username], [email], [type]
             FROM [users] JOIN [sessions]
                 ON users.username = sessions.username
             WHERE sessions.session = ?
     )#";
-    SQLite::Statement stmnt{*databs, query};
-    stmnt.bind(1, static_cast<int64_t>(session));
-    if(stmnt.executeStep()) {
-        return extractUserInfo(stmnt);
+    auto stmnt = reader().get(query);
+    stmnt->bind(1, static_cast<int64_t>(session));
+    if(stmnt->executeStep()) {
+        return extractUserInfo(*stmnt);
     }
     else {
         return {};
@@ -148,46 +411,59 @@ UserPtr Librarydb::restoreSession(std::size_t session){
 }
 
 void Librarydb::newSession(std::string username, std::size_t session) {
-    clearSession(username);
+    static auto& metric = metrics().operation("newSession");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    // Not clearSession(), which would take write_mtx a second time
+    auto clear = statements->get("DELETE FROM [sessions] WHERE username = ?");
+    clear->bind(1, username);
+    clear->exec();
     auto query = R"#(
         INSERT INTO [sessions] (username, session)
         VALUES (?, ?)
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, username);
-    stmnt.bind(2, static_cast<int64_t>(session));
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, username);
+    stmnt->bind(2, static_cast<int64_t>(session));
+    stmnt->exec();
 }
 
 void Librarydb::clearSession(std::string username) {
+    static auto& metric = metrics().operation("clearSession");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         DELETE FROM [sessions]
         WHERE username = ?
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, username);
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, username);
+    stmnt->exec();
 }
 
 BookStack Librarydb::getFavourites(std::string username) {
+    static auto& metric = metrics().operation("getFavourites");
+    ScopedTimer timed(metric);
     std::string query = R"#(
         SELECT [books].[book_id], [title], [author], [quantity], [publisher],
                 [pub_year], [description], [edition], [rating]
             FROM [favourites] JOIN [books]
                 ON favourites.book_id = books.book_id
             WHERE favourites.username = ?)#";
-    SQLite::Statement stmnt{*databs, query};
-    stmnt.bind(1, username);
+    auto stmnt = reader().get(query);
+    stmnt->bind(1, username);
 
     BookStack books;
-    while (stmnt.executeStep()) {
-        books.push_back(extractBookInfo(stmnt));
+    while (stmnt->executeStep()) {
+        books.push_back(extractBookInfo(*stmnt));
     }
 
     return std::move(books);
 }
 
 BookStack Librarydb::getBorrowed(std::string username) {
+    static auto& metric = metrics().operation("getBorrowed");
+    ScopedTimer timed(metric);
     std::string query = R"#(
         SELECT [books].[book_id], [title], [author], [quantity], [publisher],
                 [pub_year], [description], [edition], [rating]
@@ -195,34 +471,144 @@ BookStack Librarydb::getBorrowed(std::string username) {
                 ON borrows.book_id = books.book_id
             WHERE borrows.username = ?
     )#";
-    SQLite::Statement stmnt{*databs, query};
-    stmnt.bind(1, username);
+    auto stmnt = reader().get(query);
+    stmnt->bind(1, username);
 
     BookStack books;
-    while (stmnt.executeStep()) {
-        books.push_back(extractBookInfo(stmnt));
+    while (stmnt->executeStep()) {
+        books.push_back(extractBookInfo(*stmnt));
     }
     return std::move(books);
 }
 
+std::vector<std::size_t> Librarydb::getFavouriteIds(const std::string& username) {
+    static auto& metric = metrics().operation("getFavouriteIds");
+    ScopedTimer timed(metric);
+    auto stmnt = reader().get("SELECT [book_id] FROM [favourites] WHERE username = ?");
+    stmnt->bind(1, username);
+
+    std::vector<std::size_t> ids;
+    while (stmnt->executeStep()) {
+        ids.push_back(stmnt->getColumn(0).getInt64());
+    }
+    return ids;
+}
+
+std::vector<std::size_t> Librarydb::getBorrowedIds(const std::string& username) {
+    static auto& metric = metrics().operation("getBorrowedIds");
+    ScopedTimer timed(metric);
+    auto stmnt = reader().get("SELECT [book_id] FROM [borrows] WHERE username = ?");
+    stmnt->bind(1, username);
+
+    std::vector<std::size_t> ids;
+    while (stmnt->executeStep()) {
+        ids.push_back(stmnt->getColumn(0).getInt64());
+    }
+    return ids;
+}
+
 Users Librarydb::getAllUsers() {
+    static auto& metric = metrics().operation("getAllUsers");
+    ScopedTimer timed(metric);
     auto query = R"#(
         SELECT [username], [email], [type]
             FROM [users]
         WHERE NOT [username] = 'root'
     )#";
 
-    SQLite::Statement stmnt{*databs, query};
+    auto stmnt = reader().get(query);
 
     Users usrs;
-    while(stmnt.executeStep()) {
-        usrs.push_back(extractUserInfo(stmnt));
+    while(stmnt->executeStep()) {
+        usrs.push_back(extractUserInfo(*stmnt));
     }
 
     return std::move(usrs);
 }
 
 
+// Book ids are stored as signed 64 bit integers, and ordered that way
+BookStack Librarydb::getBooksPage(const std::optional<std::size_t>& after_book_id, std::size_t limit) {
+    static auto& metric = metrics().operation("getBooksPage");
+    ScopedTimer timed(metric);
+    auto first_page = R"#(
+        SELECT [book_id], [title], [author], [quantity], [publisher],
+            [pub_year], [description], [edition], [rating]
+        FROM [books]
+        ORDER BY [book_id]
+        LIMIT ?
+    )#";
+    auto next_page = R"#(
+        SELECT [book_id], [title], [author], [quantity], [publisher],
+            [pub_year], [description], [edition], [rating]
+        FROM [books]
+        WHERE [book_id] > ?
+        ORDER BY [book_id]
+        LIMIT ?
+    )#";
+
+    auto stmnt = reader().get(after_book_id ? next_page : first_page);
+    int param = 1;
+    if (after_book_id)
+        stmnt->bind(param++, static_cast<std::int64_t>(*after_book_id));
+    stmnt->bind(param, static_cast<std::int64_t>(limit));
+
+    BookStack books;
+    books.reserve(limit);
+    while (stmnt->executeStep()) {
+        books.push_back(extractBookInfo(*stmnt));
+    }
+    return books;
+}
+
+Users Librarydb::getUsersPage(const std::optional<std::string>& after_username, std::size_t limit) {
+    static auto& metric = metrics().operation("getUsersPage");
+    ScopedTimer timed(metric);
+    auto first_page = R"#(
+        SELECT [username], [email], [type]
+            FROM [users]
+        WHERE NOT [username] = 'root'
+        ORDER BY [username]
+        LIMIT ?
+    )#";
+    auto next_page = R"#(
+        SELECT [username], [email], [type]
+            FROM [users]
+        WHERE NOT [username] = 'root' AND [username] > ?
+        ORDER BY [username]
+        LIMIT ?
+    )#";
+
+    auto stmnt = reader().get(after_username ? next_page : first_page);
+    int param = 1;
+    if (after_username)
+        stmnt->bind(param++, *after_username);
+    stmnt->bind(param, static_cast<std::int64_t>(limit));
+
+    Users usrs;
+    usrs.reserve(limit);
+    while (stmnt->executeStep()) {
+        usrs.push_back(extractUserInfo(*stmnt));
+    }
+    return usrs;
+}
+
+PagedStream<BookPtr, std::size_t> Librarydb::streamBooks(std::size_t page_size) {
+    return {
+        [this](const std::optional<std::size_t>& after, std::size_t limit) { return getBooksPage(after, limit); },
+        [](const BookPtr& book) { return book->book_id; },
+        page_size
+    };
+}
+
+PagedStream<UserPtr, std::string> Librarydb::streamUsers(std::size_t page_size) {
+    return {
+        [this](const std::optional<std::string>& after, std::size_t limit) { return getUsersPage(after, limit); },
+        [](const UserPtr& usr) { return usr->username; },
+        page_size
+    };
+}
+
 UserPtr Librarydb::extractUserInfo(const SQLite::Statement& stmnt) {
     if (not stmnt.hasRow())
         return {};
@@ -236,25 +622,34 @@ UserPtr Librarydb::extractUserInfo(const SQLite::Statement& stmnt) {
 }
 
 void Librarydb::addUser(const UserPtr& nuser, std::string password){
+    static auto& metric = metrics().operation("addUser");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     std::string query = R"#(
         INSERT INTO [users]
             (email, username, password)
         VALUES (?, ?, ?)
     )#";
-    auto stmnt = SQLite::Statement(*databs, query);
-    stmnt.bind(1, nuser->email);
-    stmnt.bind(2, nuser->username);
-    stmnt.bind(3, password);
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, nuser->email);
+    stmnt->bind(2, nuser->username);
+    stmnt->bind(3, password);
+    stmnt->exec();
 }
 
 void Librarydb::removeUser(std::string username){
-    SQLite::Statement stmnt(*databs, "DELETE FROM [Users] WHERE username = ?");
-    stmnt.bind(1, username);
-    stmnt.exec();
+    static auto& metric = metrics().operation("removeUser");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto stmnt = statements->get("DELETE FROM [Users] WHERE username = ?");
+    stmnt->bind(1, username);
+    stmnt->exec();
 }
 
 void Librarydb::addBook(const BookPtr& book){
+    static auto& metric = metrics().operation("addBook");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         INSERT INTO [Books] (
                     [book_id], [title], [author], [quantity], [publisher],
@@ -262,87 +657,249 @@ void Librarydb::addBook(const BookPtr& book){
         )
         VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9)
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, static_cast<std::int64_t>(book->book_id));
-    stmnt.bind(2, book->title);
-    stmnt.bind(3, book->author);
-    stmnt.bind(4, book->quantity);
-    book->publisher.empty() ? stmnt.bind(5) : stmnt.bind(5, book->publisher);
-    book->pub_year < 0 ? stmnt.bind(6) : stmnt.bind(6, book->pub_year);
-    book->description.empty() ? stmnt.bind(7) : stmnt.bind(7, book->description);
-    book->edition < 0 ? stmnt.bind(8) : stmnt.bind(8, book->edition);
-    stmnt.bind(9, 0.0);
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, static_cast<std::int64_t>(book->book_id));
+    stmnt->bind(2, book->title);
+    stmnt->bind(3, book->author);
+    stmnt->bind(4, book->quantity);
+    book->publisher.empty() ? stmnt->bind(5) : stmnt->bind(5, book->publisher);
+    book->pub_year < 0 ? stmnt->bind(6) : stmnt->bind(6, book->pub_year);
+    book->description.empty() ? stmnt->bind(7) : stmnt->bind(7, book->description);
+    book->edition < 0 ? stmnt->bind(8) : stmnt->bind(8, book->edition);
+    stmnt->bind(9, 0.0);
+    stmnt->exec();
+}
+
+Librarydb::BookImport Librarydb::importBooks(std::size_t batch_size) {
+    static auto& metric = metrics().operation("importBooks");
+    ScopedTimer timed(metric);
+    auto query = R"#(
+        INSERT INTO [books] (
+                    [book_id], [title], [author], [quantity], [publisher],
+                    [pub_year], [description], [edition], [rating], [raters], [rating_total]
+        )
+        VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?9 * ?10)
+    )#";
+    std::unique_lock<std::mutex> writing(write_mtx);
+    return BookImport{*databs, std::move(writing), statements->get(query), batch_size};
+}
+
+void Librarydb::BookImport::add(const Book& book, bool keep_id, int raters) {
+    static auto& metric = metrics().operation("importBooks.add");
+    ScopedTimer timed(metric);
+    if (not batch)
+        batch.emplace(databs);
+
+    auto& stmnt = **insert;
+    // A row rejected last time left its error behind, which a plain reset would throw again
+    stmnt.tryReset();
+    keep_id ? stmnt.bind(1, static_cast<std::int64_t>(book.book_id)) : stmnt.bind(1);
+    stmnt.bind(2, book.title);
+    stmnt.bind(3, book.author);
+    stmnt.bind(4, book.quantity);
+    book.publisher.empty() ? stmnt.bind(5) : stmnt.bind(5, book.publisher);
+    book.pub_year < 0 ? stmnt.bind(6) : stmnt.bind(6, book.pub_year);
+    book.description.empty() ? stmnt.bind(7) : stmnt.bind(7, book.description);
+    book.edition < 0 ? stmnt.bind(8) : stmnt.bind(8, book.edition);
+    // Without a rating there are no votes for later ones to be averaged with
+    bool rated = book.rating > 0;
+    stmnt.bind(9, rated ? book.rating : 0.0);
+    stmnt.bind(10, rated ? std::max(raters, 1) : 0);
     stmnt.exec();
+
+    if (++in_batch == batch_size) {
+        batch->commit();
+        batch.reset();
+        in_batch = 0;
+    }
+}
+
+void Librarydb::BookImport::finish() {
+    static auto& metric = metrics().operation("importBooks.finish");
+    ScopedTimer timed(metric);
+    if (batch) {
+        batch->commit();
+        batch.reset();
+        in_batch = 0;
+    }
+    insert.reset();
+    if (writing.owns_lock())
+        writing.unlock();
 }
 
 void Librarydb::removeBook(std::size_t book_id) {
+    static auto& metric = metrics().operation("removeBook");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         DELETE FROM [books]
             WHERE book_id = ?
     )#";
-    SQLite::Statement stmnt{*databs, query};
-    stmnt.bind(1, static_cast<std::int64_t>(book_id));
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, static_cast<std::int64_t>(book_id));
+    stmnt->exec();
 }
 
 void Librarydb::addFavourite(std::string username, std::size_t book_id) {
+    static auto& metric = metrics().operation("addFavourite");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         INSERT INTO [favourites] (username, book_id)
         VALUES ( ?, ? );
     )#";
 
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, username);
-    stmnt.bind(2, static_cast<std::int64_t>(book_id));
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, username);
+    stmnt->bind(2, static_cast<std::int64_t>(book_id));
+    stmnt->exec();
 }
 
 void Librarydb::removeFavourite(std::string username, std::size_t book_id) {
+    static auto& metric = metrics().operation("removeFavourite");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         DELETE FROM [favourites]
         WHERE username = ? AND book_id = ?
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, username);
-    stmnt.bind(2, static_cast<std::int64_t>(book_id));
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, username);
+    stmnt->bind(2, static_cast<std::int64_t>(book_id));
+    stmnt->exec();
 }
 
-void Librarydb::borrow(std::string username, std::size_t book_id) {
+BorrowResult Librarydb::borrow(std::string username, std::size_t book_id) {
+    static auto& metric = metrics().operation("borrow");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    return borrowLocked(username, book_id);
+}
+
+BorrowResult Librarydb::borrowLocked(const std::string& username, std::size_t book_id) {
+    // Inserts nothing unless a copy is left and the user doesn't have one yet.
+    // Checked and taken in this one statement; decrease_book_number takes the copy
     auto query = R"#(
         INSERT INTO [borrows] (username, book_id)
-        VALUES ( ?, ?);
+            SELECT ?1, [book_id] FROM [books] WHERE book_id = ?2 AND quantity > 0
+        ON CONFLICT DO NOTHING
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, username);
-    stmnt.bind(2, static_cast<int64_t>(book_id));
-    stmnt.exec();
+    {
+        auto stmnt = statements->get(query);
+        stmnt->bind(1, username);
+        stmnt->bind(2, static_cast<std::int64_t>(book_id));
+        if (stmnt->exec() > 0)
+            return BorrowResult::OK;
+    }
+
+    // Refused. Only now find out why
+    auto stmnt = statements->get(R"#(
+        SELECT [quantity], EXISTS (SELECT 1 FROM [borrows] WHERE username = ?1 AND book_id = ?2)
+            FROM [books] WHERE book_id = ?2
+    )#");
+    stmnt->bind(1, username);
+    stmnt->bind(2, static_cast<std::int64_t>(book_id));
+    if (not stmnt->executeStep())
+        return BorrowResult::NO_SUCH_BOOK;
+    return stmnt->getColumn(1).getInt() ? BorrowResult::ALREADY_BORROWED : BorrowResult::OUT_OF_STOCK;
+}
+
+Librarydb::Checkout Librarydb::checkout(const std::string& username, const std::vector<std::size_t>& borrow_ids,
+                                        const std::vector<std::size_t>& return_ids) {
+    static auto& metric = metrics().operation("checkout");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    SQLite::Transaction trxn(*databs);
+
+    Checkout result;
+    // Returns first, so a copy given back can go straight out again
+    for (auto book_id : return_ids) {
+        auto stmnt = statements->get("DELETE FROM [borrows] WHERE username = ? AND book_id = ?");
+        stmnt->bind(1, username);
+        stmnt->bind(2, static_cast<std::int64_t>(book_id));
+        result.returned += stmnt->exec();
+    }
+    for (auto book_id : borrow_ids) {
+        result.borrowed.push_back(borrowLocked(username, book_id));
+    }
+
+    trxn.commit();
+    return result;
 }
 
 void Librarydb::unborrow(std::string username, std::size_t book_id) {
-    SQLite::Statement stmnt(*databs, "DELETE FROM [borrows] WHERE username = ? AND book_id = ?");
-    stmnt.bind(1, username);
-    stmnt.bind(2, static_cast<std::int64_t>(book_id));
-    stmnt.exec();
+    static auto& metric = metrics().operation("unborrow");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto stmnt = statements->get("DELETE FROM [borrows] WHERE username = ? AND book_id = ?");
+    stmnt->bind(1, username);
+    stmnt->bind(2, static_cast<std::int64_t>(book_id));
+    stmnt->exec();
 }
 
 BookStack Librarydb::getAllBooks() {
+    static auto& metric = metrics().operation("getAllBooks");
+    ScopedTimer timed(metric);
 
     auto query = R"#(
         SELECT [book_id], [title], [author], [quantity], [publisher],
             [pub_year], [description], [edition], [rating]
         FROM [books]
     )#";
-    SQLite::Statement stmnt(*databs, query);
+    auto stmnt = reader().get(query);
 
     BookStack books;
-    while (stmnt.executeStep()) {
-        books.push_back(extractBookInfo(stmnt));
+    while (stmnt->executeStep()) {
+        books.push_back(extractBookInfo(*stmnt));
     }
     return std::move(books);
 }
 
+BookStack Librarydb::searchBooks(const std::string& query, std::size_t limit) {
+    static auto& metric = metrics().operation("searchBooks");
+    ScopedTimer timed(metric);
+
+    // Every word quoted, so nothing typed is taken for FTS5 query syntax.
+    // The last one is also a prefix, since it may not be finished yet
+    std::string match;
+    std::size_t start = query.find_first_not_of(" \t");
+    while (start != std::string::npos) {
+        auto end = query.find_first_of(" \t", start);
+        auto word = query.substr(start, end == std::string::npos ? end : end - start);
+        match += match.empty() ? "\"" : " \"";
+        for (char c : word) {
+            match += c == '"' ? "\"\"" : std::string(1, c);
+        }
+        match += '"';
+        start = query.find_first_not_of(" \t", end);
+    }
+    if (match.empty())
+        return {};
+    match += '*';
+
+    // A word in the title counts the most, one in the description the least
+    auto sql = R"#(
+        SELECT [books].[book_id], [books].[title], [books].[author], [quantity], [publisher],
+            [pub_year], [books].[description], [edition], [rating]
+        FROM [books_fts] JOIN [books] ON [books].[book_id] = [books_fts].rowid
+            WHERE [books_fts] MATCH ?
+            ORDER BY bm25([books_fts], 10.0, 5.0, 1.0)
+            LIMIT ?
+    )#";
+    auto stmnt = reader().get(sql);
+    stmnt->bind(1, match);
+    stmnt->bind(2, static_cast<std::int64_t>(limit));
+
+    BookStack books;
+    while (stmnt->executeStep()) {
+        books.push_back(extractBookInfo(*stmnt));
+    }
+    return books;
+}
+
 BookPtr Librarydb::getBook(const std::size_t book_id) {
+    static auto& metric = metrics().operation("getBook");
+    ScopedTimer timed(metric);
     auto query = R"#(
         SELECT [book_id], [title], [author], [quantity], [publisher],
                     [pub_year], [description], [edition], [rating]
@@ -350,23 +907,51 @@ BookPtr Librarydb::getBook(const std::size_t book_id) {
                 WHERE book_id = ?
     )#";
 
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, static_cast<std::int64_t>(book_id));
+    auto stmnt = reader().get(query);
+    stmnt->bind(1, static_cast<std::int64_t>(book_id));
 
-    if (stmnt.executeStep()) {
-        return extractBookInfo(stmnt);
+    if (stmnt->executeStep()) {
+        return extractBookInfo(*stmnt);
     }
 
     return {};
 }
 
+BookCatalog Librarydb::getCatalog() {
+    static auto& metric = metrics().operation("getCatalog");
+    ScopedTimer timed(metric);
+    BookCatalog catalog;
+    {
+        auto count = reader().get("SELECT count(*) FROM [books]");
+        count->executeStep();
+        catalog.reserve(count->getColumn(0).getInt64());
+    }
+
+    auto query = R"#(
+        SELECT [book_id], [title], [author], [quantity], [publisher],
+            [pub_year], [description], [edition], [rating]
+        FROM [books]
+    )#";
+    auto stmnt = reader().get(query);
+
+    // One scratch Book for every row. Its strings are copied into the packed columns
+    Book book;
+    while (stmnt->executeStep()) {
+        readBookInfo(*stmnt, book);
+        catalog.push_back(book);
+    }
+    return catalog;
+}
+
 UserPtr Librarydb::authenticate(const std::string username, const std::string password) {
-    SQLite::Statement stmnt{*databs, "SELECT [username], [email], [type] FROM [Users] WHERE username = ? AND password = ?"};
-    stmnt.bind(1, username);
-    stmnt.bind(2, password);
-    if (stmnt.executeStep()) {
+    static auto& metric = metrics().operation("authenticate");
+    ScopedTimer timed(metric);
+    auto stmnt = reader().get("SELECT [username], [email], [type] FROM [Users] WHERE username = ? AND password = ?");
+    stmnt->bind(1, username);
+    stmnt->bind(2, password);
+    if (stmnt->executeStep()) {
         // correct credentials. Extract user data from columns
-        return extractUserInfo(stmnt);
+        return extractUserInfo(*stmnt);
     }
     else {
         // incorrect credentials
@@ -375,15 +960,19 @@ UserPtr Librarydb::authenticate(const std::string username, const std::string pa
 }
 
 bool Librarydb::usernameExists(const std::string& username) {
-    SQLite::Statement stmnt(*databs, "SELECT [email] FROM [users] WHERE username = ?");
-    stmnt.bind(1, username);
-    return stmnt.executeStep();
+    static auto& metric = metrics().operation("usernameExists");
+    ScopedTimer timed(metric);
+    auto stmnt = reader().get("SELECT [email] FROM [users] WHERE username = ?");
+    stmnt->bind(1, username);
+    return stmnt->executeStep();
 }
 
 bool Librarydb::emailIsUsed(const std::string& email) {
-    SQLite::Statement stmnt(*databs, "SELECT [username] FROM [users] WHERE email = ?");
-    stmnt.bind(1, email);
-    return stmnt.executeStep();
+    static auto& metric = metrics().operation("emailIsUsed");
+    ScopedTimer timed(metric);
+    auto stmnt = reader().get("SELECT [username] FROM [users] WHERE email = ?");
+    stmnt->bind(1, email);
+    return stmnt->executeStep();
 }
 
 BookPtr Librarydb::extractBookInfo(const SQLite::Statement& stmnt) {
@@ -392,72 +981,114 @@ BookPtr Librarydb::extractBookInfo(const SQLite::Statement& stmnt) {
     }
 
     auto bok = std::make_shared<Book>();
-    bok->book_id = stmnt.getColumn(0).getInt64();
-    bok->title = stmnt.getColumn(1).getString();
-    bok->author = stmnt.getColumn(2).getString();
-    bok->quantity = stmnt.getColumn(3).getInt();
-    bok->publisher = stmnt.getColumn(4).isNull() ? "" : stmnt.getColumn(4).getString();
-    bok->pub_year = stmnt.getColumn(5).isNull() ? -1 : stmnt.getColumn(5).getInt();
-    bok->description = stmnt.getColumn(6).isNull() ? "" : stmnt.getColumn(6).getString();
-    bok->edition = stmnt.getColumn(7).isNull() ? -1 : stmnt.getColumn(7).getInt();
-    bok->rating = stmnt.getColumn(8).isNull() ? -1.0 : stmnt.getColumn(8).getDouble();
+    readBookInfo(stmnt, *bok);
 
     return bok;
 }
 
+// Fills an existing Book, so a reused one keeps its string buffers
+void Librarydb::readBookInfo(const SQLite::Statement& stmnt, Book& bok) {
+    bok.book_id = stmnt.getColumn(0).getInt64();
+    bok.title = stmnt.getColumn(1).getText();
+    bok.author = stmnt.getColumn(2).getText();
+    bok.quantity = stmnt.getColumn(3).getInt();
+    bok.publisher = stmnt.getColumn(4).getText();
+    bok.pub_year = stmnt.getColumn(5).isNull() ? -1 : stmnt.getColumn(5).getInt();
+    bok.description = stmnt.getColumn(6).getText();
+    bok.edition = stmnt.getColumn(7).isNull() ? -1 : stmnt.getColumn(7).getInt();
+    bok.rating = stmnt.getColumn(8).isNull() ? -1.0 : stmnt.getColumn(8).getDouble();
+}
+
 void Librarydb::changePassword(const std::string& username, const std::string& password) {
+    static auto& metric = metrics().operation("changePassword");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         UPDATE [users] SET password = ? WHERE username = ?
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, password);
-    stmnt.bind(2, username);
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, password);
+    stmnt->bind(2, username);
+    stmnt->exec();
 }
 
 void Librarydb::makeAdmin(const std::string& username) {
-    SQLite::Statement stmnt(*databs, "UPDATE [users] SET [type] = 'Admin' WHERE [username] = ?");
-    stmnt.bind(1, username);
-    stmnt.exec();
+    static auto& metric = metrics().operation("makeAdmin");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto stmnt = statements->get("UPDATE [users] SET [type] = 'Admin' WHERE [username] = ?");
+    stmnt->bind(1, username);
+    stmnt->exec();
 }
 
 void Librarydb::demoteAdmin(const std::string& username) {
-    SQLite::Statement stmnt(*databs, "UPDATE [users] SET [type] = 'Regular' WHERE [username] = ?");
-    stmnt.bind(1, username);
-    stmnt.exec();
+    static auto& metric = metrics().operation("demoteAdmin");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    auto stmnt = statements->get("UPDATE [users] SET [type] = 'Regular' WHERE [username] = ?");
+    stmnt->bind(1, username);
+    stmnt->exec();
 }
 
-double Librarydb::rateBook(std::size_t book_id, int n){
-    SQLite::Statement stmnt(*databs, R"#(SELECT [raters], [rating] FROM "books" WHERE [book_id] = ?)#");
-    stmnt.bind(1, static_cast<std::int64_t>(book_id));
-    stmnt.executeStep();
-
-    int raters = stmnt.getColumn(0).getInt();
-    double rating = stmnt.getColumn(1).getDouble();
-    rating = ((rating * raters) + n) / (raters + 1);
-    stmnt = SQLite::Statement(*databs, R"#(UPDATE [books] SET [rating] = ? , [raters] = [raters] + 1 WHERE [book_id] = ?)#");
-    stmnt.bind(1, rating);
-    stmnt.bind(2, static_cast<std::int64_t>(book_id));
-    stmnt.exec();
+double Librarydb::rateBook(const std::string& username, std::size_t book_id, int stars){
+    static auto& metric = metrics().operation("rateBook");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
+    // The average is read back in the same transaction, so it is the one this rating made
+    SQLite::Transaction trxn(*databs);
+    {
+        // The rating triggers move the book's totals along in this same statement
+        auto stmnt = statements->get(R"#(
+            INSERT INTO [ratings] (username, book_id, stars) VALUES (?1, ?2, ?3)
+                ON CONFLICT (username, book_id) DO UPDATE SET stars = excluded.stars
+        )#");
+        stmnt->bind(1, username);
+        stmnt->bind(2, static_cast<std::int64_t>(book_id));
+        stmnt->bind(3, stars);
+        stmnt->exec();
+    }
+    double rating;
+    {
+        auto stmnt = statements->get("SELECT [rating] FROM [books] WHERE [book_id] = ?");
+        stmnt->bind(1, static_cast<std::int64_t>(book_id));
+        stmnt->executeStep();
+        rating = stmnt->getColumn(0).getDouble();
+    }
+    trxn.commit();
 
     return rating;
 }
 
 void Librarydb::updateBook(const BookPtr& book) {
+    static auto& metric = metrics().operation("updateBook");
+    ScopedTimer timed(metric);
+    std::lock_guard<std::mutex> lock(write_mtx);
     auto query = R"#(
         UPDATE "Books" SET
                     [title] = ?1, [author] = ?2, [quantity] = ?3, [publisher] = ?4,
                     [pub_year] = ?5, [description] = ?6, [edition] = ?7
         WHERE [book_id] = ?8
     )#";
-    SQLite::Statement stmnt(*databs, query);
-    stmnt.bind(1, book->title);
-    stmnt.bind(2, book->author);
-    stmnt.bind(3, book->quantity);
-    book->publisher.empty() ? stmnt.bind(4) : stmnt.bind(4, book->publisher);
-    book->pub_year < 0 ? stmnt.bind(5) : stmnt.bind(5, book->pub_year);
-    book->description.empty() ? stmnt.bind(6) : stmnt.bind(6, book->description);
-    book->edition < 0 ? stmnt.bind(7) : stmnt.bind(7, book->edition);
-    stmnt.bind(8, static_cast<std::int64_t>(book->book_id));
-    stmnt.exec();
+    auto stmnt = statements->get(query);
+    stmnt->bind(1, book->title);
+    stmnt->bind(2, book->author);
+    stmnt->bind(3, book->quantity);
+    book->publisher.empty() ? stmnt->bind(4) : stmnt->bind(4, book->publisher);
+    book->pub_year < 0 ? stmnt->bind(5) : stmnt->bind(5, book->pub_year);
+    book->description.empty() ? stmnt->bind(6) : stmnt->bind(6, book->description);
+    book->edition < 0 ? stmnt->bind(7) : stmnt->bind(7, book->edition);
+    stmnt->bind(8, static_cast<std::int64_t>(book->book_id));
+    stmnt->exec();
+}
+
+StatementCache::Stats Librarydb::statementCacheStats() const {
+    auto total = statements->stats();
+    std::shared_lock<std::shared_mutex> lock(read_pool->mtx);
+    for(auto& [id, connection] : read_pool->readers) {
+        auto stats = connection->statements.stats();
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.size += stats.size;
+    }
+    return total;
 }
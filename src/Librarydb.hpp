@@ -2,25 +2,99 @@
 
 #include "User.hpp"
 #include "Book.hpp"
+#include "BookCatalog.hpp"
+#include "Durability.hpp"
+#include "PagedStream.hpp"
+#include "StatementCache.hpp"
 
 #include "SQLiteCpp/Database.h"
 #include "SQLiteCpp/Statement.h"
+#include "SQLiteCpp/Transaction.h"
 
 #include <cstddef> // size_t
-#include <memory> // unique_ptr
+#include <memory> // shared_ptr, unique_ptr
+#include <mutex> // mutex, unique_lock
+#include <optional> // optional
+#include <shared_mutex> // shared_mutex
 #include <string> //string
+#include <thread> // thread::id
+#include <unordered_map> // unordered_map
+#include <utility> // move
+#include <vector> // vector
+
+// What came of asking to borrow a book
+enum class BorrowResult {
+    OK,
+    OUT_OF_STOCK,
+    ALREADY_BORROWED,
+    NO_SUCH_BOOK
+};
 
+// Safe to share between threads. Writes go through a single read-write
+// connection, one at a time; reads go through a read-only connection of the
+// calling thread, opened the first time it reads, so they don't queue behind
+// writes or each other.
+// Every public call is timed into metrics(), under the name of the method.
 class Librarydb{
     public:
-        Librarydb(const std::string& dbfile) : db_path(dbfile) { init(); }
+        Librarydb(const std::string& dbfile, const DurabilityProfile& durability = durabilityProfiles().front())
+            : db_path(dbfile), durability(durability) { init(); }
+        ~Librarydb();
+
+        // Bulk insert of books through one prepared statement, committed every
+        // batch_size rows instead of once per row. A row the database rejects
+        // throws from add() and is left out; the batch carries on.
+        // Other writes wait until the import is finished or destroyed.
+        class BookImport {
+            public:
+                BookImport(SQLite::Database& databs, std::unique_lock<std::mutex> writing,
+                           StatementCache::Handle insert, std::size_t batch_size)
+                    : writing(std::move(writing)), databs(databs), insert(std::move(insert)), batch_size(batch_size) {}
+
+                // Without keep_id, the database assigns the book an id. The book's
+                // rating is taken as the average of raters votes, which later ratings add to
+                void add(const Book& book, bool keep_id, int raters = 1);
+                // Commits the open batch and lets other writes through; nothing may be
+                // added afterwards. Rows added since the last batch are rolled back if it is never called
+                void finish();
+
+            private:
+                std::unique_lock<std::mutex> writing;
+                SQLite::Database& databs;
+                std::optional<StatementCache::Handle> insert; // released with the writer by finish()
+                std::size_t batch_size;
+                std::size_t in_batch = 0;
+                std::optional<SQLite::Transaction> batch;
+        };
+
+        BookImport importBooks(std::size_t batch_size);
 
         BookStack getFavourites(const std::string username);
         BookStack getBorrowed(const std::string username);
+        // Only the ids, for looking books up in an already loaded catalog
+        std::vector<std::size_t> getFavouriteIds(const std::string& username);
+        std::vector<std::size_t> getBorrowedIds(const std::string& username);
         BookStack getAllBooks(); // returns an array of Books
         BookPtr getBook(const std::size_t book_id);
+        BookCatalog getCatalog(); // all books, loaded column by column
+
+        // Full-text search of title, author and description, best match first
+        // (BM25, where the title weighs most). Books must have every word of the
+        // query; the last word may be the start of one, as while it is typed.
+        BookStack searchBooks(const std::string& query, std::size_t limit);
 
         Users getAllUsers(); // returns an array of User
 
+        // Keyset pagination. Up to limit rows following the given key, in key
+        // order, or the first ones when there is no key. Cost does not grow with
+        // how far into the table the page is.
+        BookStack getBooksPage(const std::optional<std::size_t>& after_book_id, std::size_t limit);
+        Users getUsersPage(const std::optional<std::string>& after_username, std::size_t limit);
+
+        // Whole tables, one page in memory at a time
+        PagedStream<BookPtr, std::size_t> streamBooks(std::size_t page_size = 1024);
+        PagedStream<UserPtr, std::string> streamUsers(std::size_t page_size = 1024);
+
         void addUser(const UserPtr& nuser, const std::string password);
         void removeUser(const std::string username);
 
@@ -30,9 +104,21 @@ class Librarydb{
         void addFavourite(const std::string username, const std::size_t book_id);
         void removeFavourite(const std::string username, const std::size_t book_id);
 
-        void borrow(const std::string username, const std::size_t book_id);
+        // Takes a copy only if one is left; nothing changes unless the result is OK
+        BorrowResult borrow(const std::string username, const std::size_t book_id);
         void unborrow(const std::string username, const std::size_t book_id);
 
+        struct Checkout {
+            std::vector<BorrowResult> borrowed; // one per book asked for, in the same order
+            std::size_t returned = 0; // books given back that the user did have out
+        };
+
+        // Everything a user brings to the desk, in one transaction: return_ids
+        // are given back first, then borrow_ids borrowed. Books that can't be
+        // borrowed are skipped and the rest go through; an error undoes it all.
+        Checkout checkout(const std::string& username, const std::vector<std::size_t>& borrow_ids,
+                          const std::vector<std::size_t>& return_ids);
+
         UserPtr restoreSession(std::size_t session);
         void newSession(const std::string username, std::size_t session);
         void clearSession(const std::string username);
@@ -46,14 +132,47 @@ class Librarydb{
         void makeAdmin(const std::string& username);
         void demoteAdmin(const std::string& username);
 
-        double rateBook(std::size_t book_id, int stars);
+        // Sets the user's rating of the book, 1 to 5 stars, replacing any earlier
+        // one of theirs. Returns the book's new average rating
+        double rateBook(const std::string& username, std::size_t book_id, int stars);
         void updateBook(const BookPtr& book);
+
+        StatementCache::Stats statementCacheStats() const; // summed over all connections
     private:
+        // A thread's read-only connection, with its own prepared statements
+        struct ReadConnection {
+            ReadConnection(const std::string& db_path, int busy_timeout_ms);
+
+            SQLite::Database databs;
+            StatementCache statements;
+        };
+
+        // Read connections by thread. Shared with every thread that holds one,
+        // which closes its own when it exits
+        struct ReaderPool {
+            std::shared_mutex mtx; // guards readers
+            std::unordered_map<std::thread::id, std::unique_ptr<ReadConnection>> readers;
+        };
+        struct ThreadReaders;
+
         void init();
+        StatementCache& reader();
         std::string db_path;
-        std::unique_ptr<SQLite::Database> databs;
+        DurabilityProfile durability;
+        std::unique_ptr<SQLite::Database> databs; // the writer
+        std::unique_ptr<StatementCache> statements; // declared after databs, so finalized before it closes
+        std::mutex write_mtx; // held for every write on databs
+        std::shared_ptr<ReaderPool> read_pool = std::make_shared<ReaderPool>();
         void makeSchema();
+        void makeBorrowTriggers();
+        BorrowResult borrowLocked(const std::string& username, std::size_t book_id); // write_mtx held
+        void migrate();
+        // Migrations, in the order migrate() applies them
+        void makeSearchIndex();
+        void rebuildRelationTables();
+        void makeRatings();
         BookPtr extractBookInfo(const SQLite::Statement& stmnt);
+        void readBookInfo(const SQLite::Statement& stmnt, Book& bok);
         UserPtr extractUserInfo(const SQLite::Statement& stmnt);
 };
 
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <vector> // vector
+
+// Whether each catalog slot matches the current search, worked out at most
+// once per query. Menus that list the same books ask it instead of the
+// matcher, so a book shown in several of them is only matched once.
+// A new query forgets every answer at once, without touching any of them.
+class MatchCache {
+    public:
+        explicit MatchCache(std::size_t slots) : stamps(slots, 0), matched(slots, false) {}
+
+        // The query or the catalog changed; no answer holds any more
+        void invalidate() { ++generation; }
+        // Only the book in this slot changed
+        void invalidate(std::size_t slot) {
+            if (slot < stamps.size())
+                stamps[slot] = 0;
+        }
+
+        // The answer for slot, from test() if this query hasn't asked for it yet
+        template<class Test>
+        bool matches(std::size_t slot, Test&& test) {
+            if (slot >= stamps.size())
+                return test();
+            if (stamps[slot] != generation) {
+                matched[slot] = test();
+                stamps[slot] = generation;
+            }
+            return matched[slot];
+        }
+
+    private:
+        std::uint32_t generation = 1; // 0 is never current, so it marks a stale slot
+        std::vector<std::uint32_t> stamps; // generation each answer was worked out in
+        std::vector<bool> matched;
+};
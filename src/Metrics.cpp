@@ -0,0 +1,100 @@
+#include "Metrics.hpp"
+
+#include <algorithm> // upper_bound
+#include <fstream> // ofstream
+#include <iostream> // cerr
+#include <utility> // move
+
+void OperationMetrics::record(std::chrono::steady_clock::duration took, bool failed) {
+    auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(took).count());
+    auto bucket = std::lower_bound(bucket_bounds.begin(), bucket_bounds.end(), ns) - bucket_bounds.begin();
+
+    calls.fetch_add(1, std::memory_order_relaxed);
+    if (failed)
+        errors.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+OperationMetrics& MetricsRegistry::operation(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& op : operations) {
+        if (op.name == name)
+            return op;
+    }
+    return operations.emplace_back(name);
+}
+
+void MetricsRegistry::writePrometheus(std::ostream& out, const std::string& prefix) const {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    out<<"# HELP "<<prefix<<"_call_duration_seconds Time spent in each call.\n"
+       <<"# TYPE "<<prefix<<"_call_duration_seconds histogram\n";
+    for (auto& op : operations) {
+        std::uint64_t cumulative = 0;
+        for (std::size_t b = 0; b < op.buckets.size(); ++b) {
+            cumulative += op.buckets[b].load(std::memory_order_relaxed);
+            out<<prefix<<"_call_duration_seconds_bucket{method=\""<<op.name<<"\",le=\"";
+            if (b < OperationMetrics::bucket_bounds.size())
+                out<<OperationMetrics::bucket_bounds[b] / 1e9;
+            else
+                out<<"+Inf";
+            out<<"\"} "<<cumulative<<"\n";
+        }
+        out<<prefix<<"_call_duration_seconds_sum{method=\""<<op.name<<"\"} "
+           <<op.total_ns.load(std::memory_order_relaxed) / 1e9<<"\n"
+           <<prefix<<"_call_duration_seconds_count{method=\""<<op.name<<"\"} "<<cumulative<<"\n";
+    }
+
+    out<<"# HELP "<<prefix<<"_calls_total Calls made.\n"
+       <<"# TYPE "<<prefix<<"_calls_total counter\n";
+    for (auto& op : operations) {
+        out<<prefix<<"_calls_total{method=\""<<op.name<<"\"} "<<op.calls.load(std::memory_order_relaxed)<<"\n";
+    }
+
+    out<<"# HELP "<<prefix<<"_call_errors_total Calls that ended in an exception.\n"
+       <<"# TYPE "<<prefix<<"_call_errors_total counter\n";
+    for (auto& op : operations) {
+        out<<prefix<<"_call_errors_total{method=\""<<op.name<<"\"} "<<op.errors.load(std::memory_order_relaxed)<<"\n";
+    }
+}
+
+MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsFileWriter::MetricsFileWriter(std::filesystem::path file, std::chrono::seconds interval)
+    : file(std::move(file)), interval(interval), worker([this] { run(); }) {}
+
+MetricsFileWriter::~MetricsFileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+    write();
+}
+
+void MetricsFileWriter::write() const {
+    auto partial = file;
+    partial += ".tmp";
+    {
+        std::ofstream out(partial);
+        metrics().writePrometheus(out, "librarydb");
+        if (not out) {
+            std::cerr<<"[ERROR]: Can't write metrics to "<<partial<<"\n";
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(partial, file, error);
+}
+
+void MetricsFileWriter::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (not wake.wait_for(lock, interval, [this] { return stopping; })) {
+        write();
+    }
+}
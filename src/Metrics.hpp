@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array> // array
+#include <atomic> // atomic
+#include <chrono> // steady_clock, seconds
+#include <condition_variable> // condition_variable
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <deque> // deque
+#include <exception> // uncaught_exceptions
+#include <filesystem> // path
+#include <mutex> // mutex
+#include <ostream> // ostream
+#include <string> // string
+#include <thread> // thread
+
+// Call count, error count and latency histogram of one operation. Recording
+// is a handful of relaxed atomic adds, so it can sit on every call.
+class OperationMetrics {
+    public:
+        // Upper bounds of the histogram buckets, in nanoseconds; one more bucket holds the rest
+        static constexpr std::array<std::uint64_t, 18> bucket_bounds{
+            5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+            1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000,
+            100'000'000, 250'000'000, 500'000'000, 1'000'000'000, 2'500'000'000
+        };
+
+        explicit OperationMetrics(std::string name) : name(std::move(name)) {}
+
+        void record(std::chrono::steady_clock::duration took, bool failed);
+
+        const std::string name;
+        std::atomic<std::uint64_t> calls = 0;
+        std::atomic<std::uint64_t> errors = 0;
+        std::atomic<std::uint64_t> total_ns = 0;
+        std::array<std::atomic<std::uint64_t>, bucket_bounds.size() + 1> buckets{};
+};
+
+// Times the enclosing scope into an operation. Leaving it by an exception counts as an error
+class ScopedTimer {
+    public:
+        explicit ScopedTimer(OperationMetrics& metrics) : metrics(metrics) {}
+        ~ScopedTimer() {
+            metrics.record(std::chrono::steady_clock::now() - start, std::uncaught_exceptions() > exceptions);
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        OperationMetrics& metrics;
+        int exceptions = std::uncaught_exceptions();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+// Every operation measured in the process, by name
+class MetricsRegistry {
+    public:
+        // The same object every time for a name, so callers can keep the reference
+        OperationMetrics& operation(const std::string& name);
+
+        // Prometheus text exposition format, with the given metric name prefix
+        void writePrometheus(std::ostream& out, const std::string& prefix) const;
+
+    private:
+        mutable std::mutex mtx; // guards operations, not the counters in them
+        std::deque<OperationMetrics> operations; // deque, so references stay valid as it grows
+};
+
+MetricsRegistry& metrics();
+
+// Writes the registry to a file every interval, and once more when destroyed.
+// The file is replaced whole each time, so a scraper never sees half of it.
+class MetricsFileWriter {
+    public:
+        MetricsFileWriter(std::filesystem::path file, std::chrono::seconds interval);
+        ~MetricsFileWriter();
+        MetricsFileWriter(const MetricsFileWriter&) = delete;
+        MetricsFileWriter& operator=(const MetricsFileWriter&) = delete;
+
+    private:
+        void write() const;
+        void run();
+
+        std::filesystem::path file;
+        std::chrono::seconds interval;
+        std::mutex mtx;
+        std::condition_variable wake;
+        bool stopping = false;
+        std::thread worker; // declared last, so it starts once everything it uses is ready
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional> // optional
+#include <string> // string
+#include <string_view> // string_view
+#include <vector> // vector
+
+// The rows of a list that match the search text, narrowed as the text grows.
+// Text that contains the previous text can only match rows the previous text
+// matched, so only those are checked again; any other change, such as
+// deleting a character, filters every row from scratch.
+// The rows must be left matching the last pattern between calls. Refiltering
+// them all under that same pattern, as after an item is added or removed, does.
+class NarrowingFilter {
+    public:
+        // Whether pattern only needs the rows of the last one checked again
+        bool narrows(std::string_view pattern) const {
+            return last && pattern.find(*last) != std::string_view::npos;
+        }
+
+        // Leaves in rows the indices of the items that keep accepts under
+        // pattern, which must be folded the way the matcher folds it.
+        // candidates, sorted indices holding every item keep may accept, are
+        // all that is checked when the rows can't be narrowed
+        template<class Items, class Predicate>
+        void apply(std::string_view pattern, const Items& items, Predicate&& keep, std::vector<int>& rows,
+                   const std::optional<std::vector<int>>& candidates = std::nullopt) {
+            if (narrows(pattern)) {
+                std::erase_if(rows, [&](int i) { return not keep(items[i]); });
+            }
+            else if (candidates) {
+                rows.clear();
+                for (int i : *candidates) {
+                    if (keep(items[i]))
+                        rows.push_back(i);
+                }
+            }
+            else {
+                rows.clear();
+                for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+                    if (keep(items[i]))
+                        rows.push_back(i);
+                }
+            }
+            last = pattern;
+        }
+
+    private:
+        std::optional<std::string> last;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef> // size_t, ptrdiff_t
+#include <functional> // function
+#include <iterator> // input_iterator_tag, default_sentinel_t
+#include <optional> // optional
+#include <utility> // move
+#include <vector> // vector
+
+// Streams rows in key order through a keyset page fetcher. Only one page is
+// held in memory at a time, and the next one is fetched when it runs out.
+template<class Ptr, class Key>
+class PagedStream {
+    public:
+        // Up to limit rows with a key greater than after, or from the start when there is none
+        using Fetch = std::function<std::vector<Ptr>(const std::optional<Key>& after, std::size_t limit)>;
+        using KeyOf = std::function<Key(const Ptr&)>;
+
+        PagedStream(Fetch fetch, KeyOf keyOf, std::size_t page_size)
+            : fetch(std::move(fetch)), keyOf(std::move(keyOf)), page_size(page_size) {}
+
+        // Next row, or an empty pointer once the stream is exhausted
+        Ptr next() {
+            if (pos == page.size()) {
+                if (exhausted)
+                    return {};
+                page = fetch(last, page_size);
+                pos = 0;
+                exhausted = page.size() < page_size;
+                if (page.empty())
+                    return {};
+                last = keyOf(page.back());
+            }
+            return page[pos++];
+        }
+
+        class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Ptr;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+                explicit iterator(PagedStream* stream) : stream(stream), current(stream->next()) {}
+
+                const Ptr& operator*() const { return current; }
+                iterator& operator++() { current = stream->next(); return *this; }
+                void operator++(int) { ++*this; }
+                bool operator==(std::default_sentinel_t) const { return not current; }
+
+            private:
+                PagedStream* stream = nullptr;
+                Ptr current;
+        };
+
+        iterator begin() { return iterator{this}; }
+        std::default_sentinel_t end() { return {}; }
+
+    private:
+        Fetch fetch;
+        KeyOf keyOf;
+        std::size_t page_size;
+        std::vector<Ptr> page;
+        std::size_t pos = 0;
+        std::optional<Key> last;
+        bool exhausted = false;
+};
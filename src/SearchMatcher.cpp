@@ -0,0 +1,44 @@
+#include "SearchMatcher.hpp"
+
+namespace {
+    inline unsigned char folded(char c) {
+        return static_cast<unsigned char>(foldCase(c));
+    }
+}
+
+void SearchMatcher::set(std::string_view pattern) {
+    needle.resize(pattern.size());
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        needle[i] = static_cast<char>(folded(pattern[i]));
+    }
+
+    // Horspool bad character table: how far the window may shift when the
+    // last character of it is c
+    skip.fill(needle.size());
+    for (std::size_t i = 0; i + 1 < needle.size(); ++i) {
+        skip[static_cast<unsigned char>(needle[i])] = needle.size() - 1 - i;
+    }
+}
+
+bool SearchMatcher::matches(std::string_view text) const {
+    const std::size_t n = needle.size();
+    if (n == 0)
+        return true;
+    if (text.size() < n)
+        return false;
+
+    const unsigned char last = static_cast<unsigned char>(needle[n - 1]);
+    for (std::size_t pos = 0; pos + n <= text.size(); ) {
+        const unsigned char c = folded(text[pos + n - 1]);
+        if (c == last) {
+            std::size_t i = 0;
+            while (i + 1 < n && folded(text[pos + i]) == static_cast<unsigned char>(needle[i]))
+                ++i;
+            if (i + 1 == n)
+                return true;
+        }
+        pos += skip[c];
+    }
+
+    return false;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array> // array
+#include <cstddef> // size_t
+#include <string> // string
+#include <string_view> // string_view
+
+// ASCII case folding shared by everything that matches search text.
+// Bytes of multi-byte characters are left as they are.
+inline char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Case-insensitive, literal substring search.
+// The pattern is folded to lower case and its skip table computed once, when
+// the search text changes, so testing a row is a single Horspool scan.
+// Regex metacharacters have no special meaning.
+class SearchMatcher {
+    public:
+        SearchMatcher() = default;
+        explicit SearchMatcher(std::string_view pattern) { set(pattern); }
+
+        void set(std::string_view pattern);
+
+        bool empty() const { return needle.empty(); }
+        const std::string& pattern() const { return needle; } // folded to lower case
+
+        bool matches(std::string_view text) const;
+
+    private:
+        std::string needle;
+        std::array<std::size_t, 256> skip{};
+};
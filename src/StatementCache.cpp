@@ -0,0 +1,40 @@
+#include "StatementCache.hpp"
+
+#include <mutex> // lock_guard
+#include <utility> // move
+
+StatementCache::Handle::~Handle() {
+    if (not lock.owns_lock())
+        return;
+
+    // A failed step leaves its error code behind for reset. It was already
+    // reported by the step itself, so it is not thrown again here.
+    entry->stmnt.tryReset();
+    entry->stmnt.clearBindings();
+}
+
+StatementCache::Handle StatementCache::get(std::string_view query) {
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = entries.find(query);
+        if (it != entries.end()) {
+            ++hits;
+            entry = it->second.get();
+        }
+        else {
+            ++misses;
+            std::string key{query};
+            auto prepared = std::make_unique<Entry>(databs, key);
+            entry = prepared.get();
+            entries.emplace(std::move(key), std::move(prepared));
+        }
+    }
+    // Wait for the statement outside of the map lock, so other queries are not held up
+    return Handle{*entry};
+}
+
+StatementCache::Stats StatementCache::stats() const {
+    std::lock_guard<std::mutex> guard(mtx);
+    return {hits.load(), misses.load(), entries.size()};
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SQLiteCpp/Database.h"
+#include "SQLiteCpp/Statement.h"
+
+#include <atomic> // atomic
+#include <cstddef> // size_t
+#include <functional> // equal_to, hash
+#include <memory> // unique_ptr
+#include <mutex> // mutex, unique_lock
+#include <string> // string
+#include <string_view> // string_view
+#include <unordered_map> // unordered_map
+
+// Prepared statements of a single connection, keyed by their SQL text.
+// A statement is compiled the first time it is asked for, and only reset and
+// rebound afterwards. Every statement carries its own lock, so any number of
+// threads can share the cache while each statement is used by one at a time.
+class StatementCache {
+    struct Entry {
+        Entry(const SQLite::Database& databs, const std::string& query) : stmnt(databs, query) {}
+
+        std::mutex mtx;
+        SQLite::Statement stmnt;
+    };
+
+    public:
+        // Exclusive use of a cached statement. Reset, with its bindings cleared, on release
+        class Handle {
+            public:
+                explicit Handle(Entry& entry) : lock(entry.mtx), entry(&entry) {}
+                Handle(Handle&&) = default;
+                ~Handle();
+
+                SQLite::Statement& operator*() const { return entry->stmnt; }
+                SQLite::Statement* operator->() const { return &entry->stmnt; }
+            private:
+                std::unique_lock<std::mutex> lock;
+                Entry* entry;
+        };
+
+        struct Stats {
+            std::size_t hits;
+            std::size_t misses;
+            std::size_t size; // number of distinct prepared statements
+        };
+
+        explicit StatementCache(const SQLite::Database& databs) : databs(databs) {}
+
+        Handle get(std::string_view query);
+        Stats stats() const;
+
+    private:
+        // Lets lookups by string_view skip building a std::string key
+        struct QueryHash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view query) const { return std::hash<std::string_view>{}(query); }
+        };
+
+        const SQLite::Database& databs;
+        mutable std::mutex mtx; // guards entries
+        std::unordered_map<std::string, std::unique_ptr<Entry>, QueryHash, std::equal_to<>> entries;
+        std::atomic<std::size_t> hits = 0;
+        std::atomic<std::size_t> misses = 0;
+};
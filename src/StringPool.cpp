@@ -0,0 +1,58 @@
+#include "StringPool.hpp"
+
+#include <algorithm> // copy
+#include <cstdint> // UINT32_MAX
+#include <stdexcept> // length_error
+#include <string> // string
+#include <utility> // swap
+
+StringPool::Id StringPool::intern(std::string_view text) {
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        saved += copyBytes(text);
+        return it->second;
+    }
+
+    if (strings.size() == UINT32_MAX)
+        throw std::length_error{"string pool is full"};
+
+    auto id = static_cast<Id>(strings.size());
+    auto kept = store(text);
+    strings.push_back(kept);
+    ids.emplace(kept, id);
+    return id;
+}
+
+// Size of a std::string holding text. Text longer than fits inside the object
+// goes to the heap with its terminator, in a block malloc pads with its own
+// size word and rounds up to 16 bytes
+std::size_t StringPool::copyBytes(std::string_view text) {
+    static const std::size_t inline_capacity = std::string{}.capacity();
+    if (text.size() <= inline_capacity)
+        return sizeof(std::string);
+    return sizeof(std::string) + (text.size() + 1 + sizeof(std::size_t) + 15) / 16 * 16;
+}
+
+std::string_view StringPool::store(std::string_view text) {
+    stored += text.size();
+
+    // Long strings get a block of their own, so blocks are not wasted on them
+    if (text.size() > block_size / 4) {
+        blocks.push_back(std::make_unique<char[]>(text.size()));
+        std::copy(text.begin(), text.end(), blocks.back().get());
+        std::string_view kept{blocks.back().get(), text.size()};
+        // Keep filling the current block afterwards
+        if (blocks.size() > 1)
+            std::swap(blocks[blocks.size() - 1], blocks[blocks.size() - 2]);
+        return kept;
+    }
+
+    if (block_used + text.size() > block_size) {
+        blocks.push_back(std::make_unique<char[]>(block_size));
+        block_used = 0;
+    }
+    char* at = blocks.back().get() + block_used;
+    std::copy(text.begin(), text.end(), at);
+    block_used += text.size();
+    return {at, text.size()};
+}
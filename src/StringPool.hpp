@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <memory> // unique_ptr
+#include <string_view> // string_view
+#include <unordered_map> // unordered_map
+#include <vector> // vector
+
+// Interning arena. Every distinct string is stored once, in blocks that never
+// move, and is referred to by a 4 byte id. Meant for values that repeat a lot
+// across a catalog, like authors and publishers.
+class StringPool {
+    public:
+        using Id = std::uint32_t;
+
+        StringPool() = default;
+        StringPool(StringPool&&) = default;
+        StringPool& operator=(StringPool&&) = default;
+
+        Id intern(std::string_view text);
+        std::string_view operator[](Id id) const { return strings[id]; }
+
+        std::size_t size() const { return strings.size(); } // distinct strings
+        std::size_t storedBytes() const { return stored; }
+        // Memory the strings interned again would have taken as std::string
+        // copies of their own: each object, and the heap block of a long one
+        std::size_t savedBytes() const { return saved; }
+
+    private:
+        static constexpr std::size_t block_size = 64 * 1024;
+
+        std::string_view store(std::string_view text);
+        static std::size_t copyBytes(std::string_view text);
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        std::size_t block_used = block_size;
+        std::vector<std::string_view> strings;
+        std::unordered_map<std::string_view, Id> ids; // keys point into blocks
+        std::size_t saved = 0;
+        std::size_t stored = 0;
+};
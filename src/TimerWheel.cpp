@@ -0,0 +1,91 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm> // max
+#include <utility> // move
+
+TimerWheel::Scope::Scope(TimerWheel& wheel) : wheel(wheel) {
+    std::lock_guard<std::mutex> lock(wheel.mtx);
+    id = wheel.next_owner++;
+}
+
+TimerWheel::Scope::~Scope() {
+    alive.reset();
+    wheel.cancel(id);
+}
+
+void TimerWheel::Scope::after(Clock::duration delay, std::function<void()> fn) {
+    wheel.schedule(id, alive, delay, std::move(fn));
+}
+
+TimerWheel::TimerWheel(Post post, std::chrono::milliseconds tick, std::size_t slots)
+    : post(std::move(post)), tick(tick), slots(slots), worker([this] { run(); }) {}
+
+TimerWheel::~TimerWheel() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void TimerWheel::schedule(std::uint64_t owner, std::weak_ptr<bool> alive, Clock::duration delay, std::function<void()> fn) {
+    // Whole ticks, rounded up, and at least one so nothing fires before it is due
+    auto ticks = std::max<std::size_t>(1, static_cast<std::size_t>((delay + tick - Clock::duration{1}) / tick));
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (pending++ == 0)
+            next_tick = Clock::now() + tick;
+        slots[(cursor + ticks) % slots.size()].push_back({owner, (ticks - 1) / slots.size(), std::move(alive), std::move(fn)});
+    }
+    wake.notify_one();
+}
+
+void TimerWheel::cancel(std::uint64_t owner) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& slot : slots) {
+        pending -= std::erase_if(slot, [owner](const Timer& timer) { return timer.owner == owner; });
+    }
+}
+
+void TimerWheel::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        // Idle until there is something to time; then wake once a tick
+        if (pending == 0)
+            wake.wait(lock, [this] { return stopping || pending > 0; });
+        else
+            wake.wait_until(lock, next_tick, [this] { return stopping; });
+        if (stopping)
+            return;
+        if (pending == 0 || Clock::now() < next_tick)
+            continue;
+
+        next_tick += tick;
+        cursor = (cursor + 1) % slots.size();
+        std::vector<Timer> due;
+        auto& slot = slots[cursor];
+        for (std::size_t i = 0; i < slot.size(); ) {
+            if (slot[i].rounds > 0) {
+                --slot[i].rounds;
+                ++i;
+                continue;
+            }
+            due.push_back(std::move(slot[i]));
+            if (i + 1 != slot.size())
+                slot[i] = std::move(slot.back());
+            slot.pop_back();
+        }
+        pending -= due.size();
+
+        lock.unlock();
+        for (auto& timer : due) {
+            // The scope may end between posting and running
+            post([alive = std::move(timer.alive), fn = std::move(timer.fn)] {
+                if (not alive.expired())
+                    fn();
+            });
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono> // steady_clock, milliseconds
+#include <condition_variable> // condition_variable
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <functional> // function
+#include <memory> // shared_ptr, weak_ptr
+#include <mutex> // mutex
+#include <thread> // thread
+#include <vector> // vector
+
+// Hashed timer wheel: every timed change of UI state goes through the one
+// thread it owns, however many timers are pending. Timers are kept in a ring
+// of slots, one per tick, so scheduling and cancelling never sort anything.
+// Callbacks don't run on the wheel's thread; they are handed to `post`, which
+// has to run them on the UI thread.
+class TimerWheel {
+    public:
+        using Post = std::function<void(std::function<void()>)>;
+        using Clock = std::chrono::steady_clock;
+
+        // Timers belonging to one screen. Destroying the scope cancels those
+        // still pending, including any already posted but not yet run.
+        class Scope {
+            public:
+                explicit Scope(TimerWheel& wheel);
+                ~Scope();
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+                // Runs fn on the UI thread once delay has passed, to within a tick
+                void after(Clock::duration delay, std::function<void()> fn);
+
+            private:
+                TimerWheel& wheel;
+                std::uint64_t id;
+                std::shared_ptr<bool> alive = std::make_shared<bool>(true);
+        };
+
+        explicit TimerWheel(Post post, std::chrono::milliseconds tick = std::chrono::milliseconds{50}, std::size_t slots = 64);
+        ~TimerWheel(); // drops the timers still pending
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+    private:
+        struct Timer {
+            std::uint64_t owner;
+            std::size_t rounds; // full turns of the wheel left before it is due
+            std::weak_ptr<bool> alive;
+            std::function<void()> fn;
+        };
+
+        void schedule(std::uint64_t owner, std::weak_ptr<bool> alive, Clock::duration delay, std::function<void()> fn);
+        void cancel(std::uint64_t owner);
+        void run();
+
+        Post post;
+        Clock::duration tick;
+        std::mutex mtx; // guards everything below
+        std::condition_variable wake;
+        std::vector<std::vector<Timer>> slots;
+        std::size_t cursor = 0;
+        std::size_t pending = 0;
+        std::uint64_t next_owner = 0;
+        Clock::time_point next_tick;
+        bool stopping = false;
+        std::thread worker; // declared last, so it starts once everything it uses is ready
+};
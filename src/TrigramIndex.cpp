@@ -0,0 +1,99 @@
+#include "TrigramIndex.hpp"
+#include "SearchMatcher.hpp"
+
+#include <algorithm> // sort, unique, lower_bound, set_intersection
+#include <iterator> // back_inserter
+#include <utility> // move
+
+TrigramIndex::TrigramIndex(const BookStack& books) {
+    // Bulk build: append everything, then sort each posting list once
+    for (auto& book : books) {
+        auto grams = trigramsOf(*book);
+        for (auto gram : grams) {
+            postings[gram].push_back(book->book_id);
+        }
+        indexed[book->book_id] = std::move(grams);
+    }
+    for (auto& [gram, ids] : postings) {
+        std::sort(ids.begin(), ids.end());
+    }
+}
+
+void TrigramIndex::collect(std::string_view text, std::vector<Trigram>& out) {
+    for (std::size_t i = 0; i + 3 <= text.size(); ++i) {
+        out.push_back(static_cast<Trigram>(static_cast<unsigned char>(foldCase(text[i]))) << 16
+                    | static_cast<Trigram>(static_cast<unsigned char>(foldCase(text[i + 1]))) << 8
+                    | static_cast<Trigram>(static_cast<unsigned char>(foldCase(text[i + 2]))));
+    }
+}
+
+// Trigrams of title and author, each taken on its own, so none spans the two
+std::vector<TrigramIndex::Trigram> TrigramIndex::trigramsOf(const Book& book) {
+    std::vector<Trigram> grams;
+    collect(book.title, grams);
+    collect(book.author, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::add(const Book& book) {
+    auto grams = trigramsOf(book);
+    for (auto gram : grams) {
+        auto& ids = postings[gram];
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), book.book_id), book.book_id);
+    }
+    indexed[book.book_id] = std::move(grams);
+}
+
+void TrigramIndex::update(const Book& book) {
+    remove(book.book_id);
+    add(book);
+}
+
+void TrigramIndex::remove(std::size_t book_id) {
+    auto it = indexed.find(book_id);
+    if (it == indexed.end())
+        return;
+
+    for (auto gram : it->second) {
+        auto posting = postings.find(gram);
+        auto& ids = posting->second;
+        auto pos = std::lower_bound(ids.begin(), ids.end(), book_id);
+        if (pos != ids.end() && *pos == book_id)
+            ids.erase(pos);
+        if (ids.empty())
+            postings.erase(posting);
+    }
+    indexed.erase(it);
+}
+
+std::optional<std::vector<std::size_t>> TrigramIndex::candidates(std::string_view query) const {
+    std::vector<Trigram> grams;
+    collect(query, grams);
+    if (grams.empty())
+        return std::nullopt;
+
+    // Intersect the posting lists, shortest first, so the working set only shrinks
+    std::vector<const std::vector<std::size_t>*> lists;
+    for (auto gram : grams) {
+        auto posting = postings.find(gram);
+        if (posting == postings.end())
+            return std::vector<std::size_t>{};
+        lists.push_back(&posting->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+
+    std::vector<std::size_t> result = *lists.front();
+    std::vector<std::size_t> narrowed;
+    for (std::size_t i = 1; i < lists.size() && not result.empty(); ++i) {
+        if (lists[i] == lists[i - 1])
+            continue;
+        narrowed.clear();
+        std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(narrowed));
+        result.swap(narrowed);
+    }
+
+    return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Book.hpp"
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <optional> // optional
+#include <string_view> // string_view
+#include <unordered_map> // unordered_map
+#include <vector> // vector
+
+// Inverted index from the case-folded trigrams of each book's title and
+// author to book ids. A query can only match books that contain every one of
+// its trigrams, so only those need to be checked against the SearchMatcher.
+class TrigramIndex {
+    public:
+        TrigramIndex() = default;
+        explicit TrigramIndex(const BookStack& books);
+
+        void add(const Book& book);
+        void update(const Book& book);
+        void remove(std::size_t book_id);
+
+        // Sorted ids of the books that may contain query. Nothing when the
+        // query is shorter than a trigram, in which case every book may.
+        std::optional<std::vector<std::size_t>> candidates(std::string_view query) const;
+
+        std::size_t size() const { return indexed.size(); }
+
+    private:
+        using Trigram = std::uint32_t;
+
+        static void collect(std::string_view text, std::vector<Trigram>& out);
+        static std::vector<Trigram> trigramsOf(const Book& book);
+
+        std::unordered_map<Trigram, std::vector<std::size_t>> postings; // each sorted by book id
+        std::unordered_map<std::size_t, std::vector<Trigram>> indexed; // what each book was indexed under
+};
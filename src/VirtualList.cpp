@@ -0,0 +1,155 @@
+#include "VirtualList.hpp"
+
+#include "ftxui/component/component_base.hpp"
+#include "ftxui/component/event.hpp"
+#include "ftxui/component/mouse.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/screen/box.hpp"
+#include "ftxui/screen/terminal.hpp"
+
+#include <algorithm> // clamp, find, min, max
+#include <utility> // move
+
+namespace {
+    class VirtualListBase : public ftxui::ComponentBase {
+        public:
+            VirtualListBase(const std::vector<int>* rows, int* selected, VirtualListOption option)
+                : rows(rows), selected(selected), option(std::move(option)) {}
+
+            ftxui::Element OnRender() override {
+                using namespace ftxui;
+                sync();
+
+                const int first = offset;
+                const int last = std::min<int>(rows->size(), offset + viewportHeight());
+                Elements entries;
+                entries.reserve(last - first);
+                for (int i = first; i < last; ++i) {
+                    EntryState state;
+                    state.label = option.label((*rows)[i]);
+                    state.state = false;
+                    state.active = i == cursor;
+                    state.focused = state.active && Focused();
+                    auto entry = option.entries_option.transform(state);
+                    entries.push_back(state.active ? entry | focus : entry);
+                }
+
+                return vbox(std::move(entries)) | yframe | yflex | reflect(box);
+            }
+
+            bool OnEvent(ftxui::Event event) override {
+                using namespace ftxui;
+                if (rows->empty())
+                    return false;
+                sync();
+
+                if (event.is_mouse())
+                    return onMouse(event);
+                if (not Focused())
+                    return false;
+
+                const int page = viewportHeight();
+                int target = cursor;
+                if (event == Event::ArrowUp)
+                    --target;
+                else if (event == Event::ArrowDown)
+                    ++target;
+                else if (event == Event::PageUp)
+                    target -= page;
+                else if (event == Event::PageDown)
+                    target += page;
+                else if (event == Event::Home)
+                    target = 0;
+                else if (event == Event::End)
+                    target = static_cast<int>(rows->size()) - 1;
+                else
+                    return false;
+
+                target = std::clamp(target, 0, static_cast<int>(rows->size()) - 1);
+                if (target == cursor)
+                    return event == Event::PageUp || event == Event::PageDown || event == Event::Home || event == Event::End;
+                moveTo(target);
+                return true;
+            }
+
+            bool Focusable() const override {
+                return not rows->empty();
+            }
+
+        private:
+            bool onMouse(ftxui::Event& event) {
+                using namespace ftxui;
+                if (not CaptureMouse(event) || not box.Contain(event.mouse().x, event.mouse().y))
+                    return false;
+
+                auto& mouse = event.mouse();
+                if (mouse.button == Mouse::WheelUp || mouse.button == Mouse::WheelDown) {
+                    int step = mouse.button == Mouse::WheelUp ? -1 : 1;
+                    moveTo(std::clamp(cursor + step, 0, static_cast<int>(rows->size()) - 1));
+                    return true;
+                }
+                if (mouse.button == Mouse::Left && mouse.motion == Mouse::Pressed) {
+                    int clicked = offset + (mouse.y - box.y_min);
+                    if (clicked >= static_cast<int>(rows->size()))
+                        return false;
+                    TakeFocus();
+                    moveTo(clicked);
+                    return true;
+                }
+                return false;
+            }
+
+            // Rows fitting in the viewport. Before the first frame, the terminal height
+            int viewportHeight() const {
+                int height = box.y_max - box.y_min + 1;
+                if (height <= 1)
+                    height = ftxui::Terminal::Size().dimy;
+                return std::max(height, 1);
+            }
+
+            void moveTo(int position) {
+                cursor = position;
+                *selected = (*rows)[cursor];
+                scrollToCursor();
+            }
+
+            // Keep the cursor on the selected item as rows are filtered, added and
+            // removed underneath. Falls back to the nearest row when it is gone.
+            void sync() {
+                if (rows->empty()) {
+                    cursor = offset = 0;
+                    return;
+                }
+
+                const int count = static_cast<int>(rows->size());
+                if (cursor >= count || (*rows)[cursor] != *selected) {
+                    auto found = std::find(rows->begin(), rows->end(), *selected);
+                    if (found != rows->end())
+                        cursor = static_cast<int>(found - rows->begin());
+                    else
+                        moveTo(std::clamp(cursor, 0, count - 1));
+                }
+                scrollToCursor();
+            }
+
+            void scrollToCursor() {
+                const int height = viewportHeight();
+                if (cursor < offset)
+                    offset = cursor;
+                else if (cursor >= offset + height)
+                    offset = cursor - height + 1;
+                offset = std::clamp(offset, 0, std::max(0, static_cast<int>(rows->size()) - height));
+            }
+
+            const std::vector<int>* rows;
+            int* selected;
+            VirtualListOption option;
+            int cursor = 0; // position of the selected item in rows
+            int offset = 0; // position in rows of the first visible row
+            ftxui::Box box;
+    };
+}
+
+ftxui::Component VirtualList(const std::vector<int>* rows, int* selected, VirtualListOption option) {
+    return ftxui::Make<VirtualListBase>(rows, selected, std::move(option));
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/component/component_options.hpp"
+
+#include <functional> // function
+#include <string> // string
+#include <vector> // vector
+
+struct VirtualListOption {
+    // Label of the item at an index of the underlying vector
+    std::function<std::string(int)> label;
+    // How a single row is drawn
+    ftxui::MenuEntryOption entries_option;
+};
+
+// Menu over a large vector that only builds the rows visible in its viewport.
+// `rows` holds the indices, into the underlying vector, of the items to list,
+// in order; filtering means changing `rows`. `selected` is an index into the
+// underlying vector too, so it can be used to look the selected item up directly.
+ftxui::Component VirtualList(const std::vector<int>* rows, int* selected, VirtualListOption option);
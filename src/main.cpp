@@ -1,9 +1,14 @@
 #include "App.hpp"
+#include "Batch.hpp"
+#include "Export.hpp"
+#include "Import.hpp"
 #include "Librarydb.hpp"
+#include "Metrics.hpp"
 #include "SQLiteCpp/Exception.h"
 
-#include <iostream> // cerr
-#include <cstdlib> // EXIT_FAILURE
+#include <chrono> // seconds
+#include <iostream> // cerr, cout, cin
+#include <cstdlib> // EXIT_FAILURE, EXIT_SUCCESS
 #include <exception> // exception
 #include <filesystem> // create_directory, canonical, is_regular_file
 #include <iterator> // next
@@ -11,27 +16,52 @@
 #include <stdexcept> // invalid_argument
 #include <vector> // vector
 #include <string> // string
-#include <fstream> // ofstream
+#include <fstream> // ofstream, ifstream
 
 void print_usage() {
 std::cerr<<
 R"#(
 Library Management System
 
-Usage: library [-n] [-d dbfile]
-    -n          Start new session
-    -d FILE     Open database file FILE
+Usage: library [-n] [-s] [-d dbfile] [-p profile] [--import FILE] [--export DIR [--format csv|jsonl]] [--batch [FILE]]
+             [--metrics FILE [--metrics-interval SECONDS]]
+    -n              Start new session
+    -s              Print statement cache statistics on exit
+    -d FILE         Open database file FILE
+    -p PROFILE      Durability profile: safe (default), wal-balanced or bulk-load
+    --import FILE   Add the books in FILE (.csv or .jsonl) to the database and exit
+    --export DIR    Write books, users, borrows and favourites to files in DIR and exit
+    --format FMT    Format of exported files: csv (default) or jsonl
+    --batch [FILE]  Run the commands in FILE, or on stdin, without the interface and exit.
+                    One per line: login USER PASSWORD, logout, borrow ID, return ID, like ID,
+                    rate ID STARS, add-book TITLE AUTHOR QUANTITY [PUBLISHER [YEAR [EDITION [DESCRIPTION]]]],
+                    search TEXT, find WORDS, checkout [ID...] [return ID...]
+    --metrics FILE  Keep per-call latency histograms and call/error counts of every database
+                    operation in FILE, in Prometheus text format. Rewritten every interval and on exit
+    --metrics-interval SECONDS
+                    How often to rewrite the metrics file (default 15)
 )#";
 }
 
 int main(int argc, char** argv) {
     std::vector<std::string> args{argv+1, argv+argc};
     bool new_session = false;
+    bool print_stats = false;
     std::string db_path;
+    std::string profile_name = "safe";
+    std::string import_path;
+    std::string export_dir;
+    ExportFormat export_format = ExportFormat::CSV;
+    bool batch = false;
+    std::string batch_path;
+    std::string metrics_path;
+    int metrics_interval = 15;
 
     for(auto it = args.begin(); it != args.end(); ++it) {
         if(*it == "-n")
             new_session = true;
+        else if(*it == "-s")
+            print_stats = true;
         else if (*it == "-d") {
             if(std::next(it) == args.end()){
                 print_usage();
@@ -40,6 +70,72 @@ int main(int argc, char** argv) {
             db_path = *std::next(it);
             ++it;
         }
+        else if (*it == "-p") {
+            if(std::next(it) == args.end()){
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            profile_name = *std::next(it);
+            try {
+                durabilityProfile(profile_name);
+            }
+            catch(const std::invalid_argument& e) {
+                std::cerr<<"[ERROR]: "<<e.what()<<"\n";
+                return EXIT_FAILURE;
+            }
+            ++it;
+        }
+        else if (*it == "--import") {
+            if(std::next(it) == args.end()){
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            import_path = *std::next(it);
+            ++it;
+        }
+        else if (*it == "--export") {
+            if(std::next(it) == args.end()){
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            export_dir = *std::next(it);
+            ++it;
+        }
+        else if (*it == "--batch") {
+            batch = true;
+            // The file is optional; without one, commands come from stdin
+            if(std::next(it) != args.end() && not std::next(it)->starts_with("-")) {
+                batch_path = *std::next(it);
+                ++it;
+            }
+        }
+        else if (*it == "--metrics") {
+            if(std::next(it) == args.end()){
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            metrics_path = *std::next(it);
+            ++it;
+        }
+        else if (*it == "--metrics-interval") {
+            try {
+                if(std::next(it) == args.end() || (metrics_interval = std::stoi(*std::next(it))) <= 0)
+                    throw std::invalid_argument{"interval"};
+            }
+            catch(const std::exception& e) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            ++it;
+        }
+        else if (*it == "--format") {
+            if(std::next(it) == args.end() || (*std::next(it) != "csv" && *std::next(it) != "jsonl")){
+                print_usage();
+                return EXIT_FAILURE;
+            }
+            export_format = *std::next(it) == "csv" ? ExportFormat::CSV : ExportFormat::JSON_LINES;
+            ++it;
+        }
         else {
             print_usage();
             return EXIT_FAILURE;
@@ -87,8 +183,14 @@ int main(int argc, char** argv) {
         db_path = path;
     }
 
+    // Ahead of every early return below, so each of them still writes the final dump
+    std::unique_ptr<MetricsFileWriter> metrics_writer;
+    if(not metrics_path.empty()) {
+        metrics_writer = std::make_unique<MetricsFileWriter>(metrics_path, std::chrono::seconds{metrics_interval});
+    }
+
     try {
-        db = std::make_unique<Librarydb>(db_path);
+        db = std::make_unique<Librarydb>(db_path, durabilityProfile(profile_name));
     }
     catch(const std::invalid_argument& e) {
         std::cerr<<"[ERROR] Failed to open database: <"<<e.what()<<">"<<std::endl;
@@ -99,11 +201,63 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    if(not import_path.empty()) {
+        ImportSummary summary;
+        try {
+            summary = importBooks(*db, import_path, std::cerr);
+        }
+        catch(const std::exception& e) {
+            std::cerr<<"[ERROR] Import failed: <"<<e.what()<<">"<<std::endl;
+            return EXIT_FAILURE;
+        }
+
+        for(auto& error : summary.errors) {
+            std::cerr<<import_path<<":"<<error.line<<": "<<error.message<<"\n";
+        }
+        std::cerr<<"Imported "<<summary.imported<<" books in "<<summary.seconds<<"s, "
+            <<summary.failed<<" rejected\n";
+        return summary.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(not export_dir.empty()) {
+        try {
+            for(auto& table : exportTables(db_path, export_dir, export_format)) {
+                std::cerr<<"Exported "<<table.rows<<" rows of "<<table.table<<" to "<<table.file.string()
+                    <<" in "<<table.seconds<<"s\n";
+            }
+        }
+        catch(const std::exception& e) {
+            std::cerr<<"[ERROR] Export failed: <"<<e.what()<<">"<<std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if(batch) {
+        std::ifstream file;
+        if(not batch_path.empty()) {
+            file.open(batch_path);
+            if(not file) {
+                std::cerr<<"[ERROR]: Can't open "<<batch_path<<"\n";
+                return EXIT_FAILURE;
+            }
+        }
+        auto summary = runBatch(*db, batch_path.empty() ? std::cin : file, std::cout, std::cerr);
+        return summary.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     ap = std::make_unique<App>();
     ap->session_file = data_dir / "session.txt";
     if(new_session){
         ap->newSession = true;
     }
 
-    return ap->run();
+    int status = ap->run();
+    if(print_stats) {
+        auto stats = db->statementCacheStats();
+        std::cerr<<"Statement cache: "<<stats.size<<" statements, "
+            <<stats.hits<<" hits, "<<stats.misses<<" misses\n";
+    }
+
+    return status;
 }
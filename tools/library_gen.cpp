@@ -0,0 +1,333 @@
+#include "Book.hpp"
+#include "Durability.hpp"
+#include "Librarydb.hpp"
+
+#include "SQLiteCpp/Database.h"
+#include "SQLiteCpp/Exception.h"
+#include "SQLiteCpp/Statement.h"
+#include "SQLiteCpp/Transaction.h"
+
+#include <algorithm> // lower_bound, shuffle, sort, min
+#include <chrono> // steady_clock
+#include <cmath> // pow
+#include <cstdint> // uint64_t, int64_t
+#include <cstdlib> // EXIT_FAILURE, EXIT_SUCCESS
+#include <exception> // exception
+#include <filesystem> // exists
+#include <fstream> // ofstream
+#include <iostream> // cerr
+#include <numeric> // iota
+#include <random> // mt19937_64, uniform_int_distribution, uniform_real_distribution
+#include <stdexcept> // invalid_argument
+#include <string> // string, stoull, stod
+#include <unordered_set> // unordered_set
+#include <utility> // pair
+#include <vector> // vector
+
+namespace {
+    void print_usage() {
+        std::cerr<<
+R"#(
+Synthetic library database generator
+
+Usage: library_gen -o FILE [options]
+    -o FILE                 Database file to create. Must not exist yet
+    --books N               Books to create (100000)
+    --users N               Regular users to create, besides root (10000)
+    --borrows N             Borrowed (user, book) pairs (50000)
+    --favourites N          Favourite (user, book) pairs (100000)
+    --skew S                Zipf exponent of book popularity for borrows and favourites (1.0)
+    --authors N             Distinct authors (5000)
+    --author-skew S         Zipf exponent of books per author (0.8)
+    --title-words MIN:MAX   Words per title (1:6)
+    --seed N                Random seed (1)
+)#";
+    }
+
+    struct Options {
+        std::string file;
+        std::size_t books = 100'000;
+        std::size_t users = 10'000;
+        std::size_t borrows = 50'000;
+        std::size_t favourites = 100'000;
+        double skew = 1.0;
+        std::size_t authors = 5'000;
+        double author_skew = 0.8;
+        std::size_t min_title_words = 1;
+        std::size_t max_title_words = 6;
+        std::uint64_t seed = 1;
+    };
+
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 == argc)
+                throw std::invalid_argument{arg + " needs a value"};
+            std::string value = argv[++i];
+
+            if (arg == "-o")
+                options.file = value;
+            else if (arg == "--books")
+                options.books = std::stoull(value);
+            else if (arg == "--users")
+                options.users = std::stoull(value);
+            else if (arg == "--borrows")
+                options.borrows = std::stoull(value);
+            else if (arg == "--favourites")
+                options.favourites = std::stoull(value);
+            else if (arg == "--skew")
+                options.skew = std::stod(value);
+            else if (arg == "--authors")
+                options.authors = std::stoull(value);
+            else if (arg == "--author-skew")
+                options.author_skew = std::stod(value);
+            else if (arg == "--title-words") {
+                auto colon = value.find(':');
+                if (colon == std::string::npos)
+                    throw std::invalid_argument{"--title-words takes MIN:MAX"};
+                options.min_title_words = std::stoull(value.substr(0, colon));
+                options.max_title_words = std::stoull(value.substr(colon + 1));
+            }
+            else if (arg == "--seed")
+                options.seed = std::stoull(value);
+            else
+                throw std::invalid_argument{"unknown option " + arg};
+        }
+
+        if (options.file.empty())
+            throw std::invalid_argument{"no output file given"};
+        if (options.books == 0 || options.authors == 0)
+            throw std::invalid_argument{"--books and --authors must be at least 1"};
+        if (options.min_title_words == 0 || options.min_title_words > options.max_title_words)
+            throw std::invalid_argument{"--title-words needs 0 < MIN <= MAX"};
+        // Every pair is distinct, so there can't be more of them than users times books
+        auto pairs = options.users * options.books;
+        if (options.borrows > pairs || options.favourites > pairs)
+            throw std::invalid_argument{"more borrows or favourites than (user, book) pairs"};
+        return options;
+    }
+
+    // Draws ranks 0..n-1, rank r with probability proportional to 1 / (r + 1)^s
+    class Zipf {
+        public:
+            Zipf(std::size_t n, double s) : cdf(n) {
+                double sum = 0;
+                for (std::size_t r = 0; r < n; ++r) {
+                    sum += std::pow(static_cast<double>(r + 1), -s);
+                    cdf[r] = sum;
+                }
+                for (auto& c : cdf) {
+                    c /= sum;
+                }
+            }
+
+            template<class Rng>
+            std::size_t operator()(Rng& rng) {
+                auto rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+                return std::min(static_cast<std::size_t>(rank), cdf.size() - 1);
+            }
+
+        private:
+            std::vector<double> cdf;
+            std::uniform_real_distribution<double> uniform{0.0, 1.0};
+    };
+
+    const std::vector<std::string> title_words{
+        "the", "of", "a", "night", "river", "empire", "silent", "garden", "machine", "history", "shadow",
+        "winter", "code", "stone", "light", "house", "war", "memory", "ocean", "city", "secret", "red",
+        "last", "first", "kingdom", "storm", "letters", "song", "journey", "island", "fire", "glass",
+        "mountain", "children", "dark", "road", "north", "silver", "book", "time", "daughter", "stranger"
+    };
+    const std::vector<std::string> name_syllables{
+        "an", "ber", "ca", "dor", "el", "fa", "gen", "ha", "is", "jo", "ka", "lin", "mo", "na",
+        "or", "pe", "qui", "ra", "so", "ta", "ul", "vi", "wen", "xa", "yu", "zo"
+    };
+    const std::vector<std::string> publishers{
+        "Penguin", "Vintage", "Harper", "Macmillan", "Bloomsbury", "Faber", "Heinemann", "Orbit", "Tor", "Virago"
+    };
+
+    std::string capitalized(std::string word) {
+        word[0] = static_cast<char>(word[0] - 'a' + 'A');
+        return word;
+    }
+
+    template<class Rng>
+    std::string randomName(Rng& rng) {
+        std::uniform_int_distribution<std::size_t> syllable(0, name_syllables.size() - 1);
+        std::uniform_int_distribution<int> length(2, 3);
+        std::string first, last;
+        for (int n = length(rng); n > 0; --n) {
+            first += name_syllables[syllable(rng)];
+        }
+        for (int n = length(rng); n > 0; --n) {
+            last += name_syllables[syllable(rng)];
+        }
+        return capitalized(first) + " " + capitalized(last);
+    }
+
+    // Distinct (user, book) pairs, books drawn by popularity. Popularity ranks
+    // are spread over the catalog, so the most wanted books aren't just the first ids
+    template<class Rng>
+    std::vector<std::pair<std::size_t, std::size_t>> drawPairs(std::size_t count, std::size_t users, Zipf& popularity,
+                                                              const std::vector<std::size_t>& book_of_rank, Rng& rng) {
+        std::vector<std::pair<std::size_t, std::size_t>> pairs;
+        if (users == 0)
+            return pairs;
+        pairs.reserve(count);
+        std::unordered_set<std::uint64_t> seen;
+        seen.reserve(count);
+        std::uniform_int_distribution<std::size_t> user(0, users - 1);
+        std::uniform_int_distribution<std::size_t> any_book(0, book_of_rank.size() - 1);
+
+        for (std::size_t draws = 0; pairs.size() < count; ++draws) {
+            auto u = user(rng);
+            // Popular books saturate once most users have them; after that many draws any book will do
+            auto book = draws < count * 4 ? book_of_rank[popularity(rng)] : any_book(rng);
+            if (seen.insert(static_cast<std::uint64_t>(u) * book_of_rank.size() + book).second)
+                pairs.emplace_back(u, book);
+        }
+        return pairs;
+    }
+
+    std::string username(std::size_t user) {
+        return "user" + std::to_string(user + 1);
+    }
+
+    class Stopwatch {
+        public:
+            double seconds() const {
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+        private:
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    void generate(const Options& options) {
+        Stopwatch total;
+        std::mt19937_64 rng{options.seed};
+
+        std::vector<std::size_t> book_of_rank(options.books);
+        std::iota(book_of_rank.begin(), book_of_rank.end(), 0);
+        std::shuffle(book_of_rank.begin(), book_of_rank.end(), rng);
+        Zipf popularity{options.books, options.skew};
+
+        // Borrowing a book takes a copy off the shelf, so the borrows are drawn
+        // first and every book gets at least as many copies as it has borrowers
+        auto borrows = drawPairs(options.borrows, options.users, popularity, book_of_rank, rng);
+        auto favourites = drawPairs(options.favourites, options.users, popularity, book_of_rank, rng);
+        std::vector<int> borrowers(options.books);
+        for (auto [user, book] : borrows) {
+            ++borrowers[book];
+        }
+
+        std::vector<std::string> authors(options.authors);
+        for (auto& author : authors) {
+            author = randomName(rng);
+        }
+        Zipf author_popularity{options.authors, options.author_skew};
+
+        std::ofstream{options.file};
+        Stopwatch books_time;
+        {
+            Librarydb library{options.file, durabilityProfile("bulk-load")};
+            auto import = library.importBooks(100'000);
+
+            std::uniform_int_distribution<std::size_t> words(options.min_title_words, options.max_title_words);
+            std::uniform_int_distribution<std::size_t> word(0, title_words.size() - 1);
+            std::uniform_int_distribution<std::size_t> publisher(0, publishers.size() - 1);
+            std::uniform_int_distribution<int> spare_copies(0, 5), year(1850, 2024), edition(1, 4), tenths(10, 50), raters(1, 200);
+
+            Book book;
+            for (std::size_t i = 0; i < options.books; ++i) {
+                book.book_id = i + 1;
+                book.title.clear();
+                for (auto n = words(rng); n > 0; --n) {
+                    book.title += (book.title.empty() ? capitalized(title_words[word(rng)]) : " " + title_words[word(rng)]);
+                }
+                book.author = authors[author_popularity(rng)];
+                book.quantity = borrowers[i] + spare_copies(rng);
+                book.publisher = publishers[publisher(rng)];
+                book.pub_year = year(rng);
+                book.edition = edition(rng);
+                book.rating = tenths(rng) / 10.0;
+                import.add(book, true, raters(rng));
+            }
+            import.finish();
+        }
+        std::cerr<<options.books<<" books in "<<books_time.seconds()<<"s\n";
+
+        // Users and relations go straight through prepared statements, in one
+        // transaction, with foreign key checks off: they hold by construction
+        SQLite::Database databs(options.file, SQLite::OPEN_READWRITE);
+        applyDurability(databs, durabilityProfile("bulk-load"));
+        // Room for the books table and the relation indexes, which the borrow trigger and inserts keep revisiting
+        databs.exec("PRAGMA cache_size = -262144");
+        {
+            Stopwatch rows_time;
+            SQLite::Transaction trxn(databs);
+
+            std::vector<std::string> usernames(options.users);
+            for (std::size_t u = 0; u < options.users; ++u) {
+                usernames[u] = username(u);
+            }
+
+            SQLite::Statement add_user(databs, "INSERT INTO [users] (username, email, password) VALUES (?, ?, ?)");
+            for (auto& name : usernames) {
+                add_user.bind(1, name);
+                add_user.bind(2, name + "@example.com");
+                add_user.bind(3, name);
+                add_user.exec();
+                add_user.reset();
+            }
+
+            for (auto [table, pairs] : {std::pair{"borrows", &borrows}, std::pair{"favourites", &favourites}}) {
+                // In primary key order, so every insert appends to the index instead of landing on a random page
+                std::sort(pairs->begin(), pairs->end(), [&usernames](auto& a, auto& b) {
+                    return usernames[a.first] != usernames[b.first] ? usernames[a.first] < usernames[b.first] : a.second < b.second;
+                });
+                SQLite::Statement add_pair(databs, std::string{"INSERT INTO ["} + table + "] (username, book_id) VALUES (?, ?)");
+                for (auto [user, book] : *pairs) {
+                    add_pair.bind(1, usernames[user]);
+                    add_pair.bind(2, static_cast<std::int64_t>(book + 1));
+                    add_pair.exec();
+                    add_pair.reset();
+                }
+            }
+            trxn.commit();
+            std::cerr<<options.users<<" users, "<<borrows.size()<<" borrows and "<<favourites.size()
+                <<" favourites in "<<rows_time.seconds()<<"s\n";
+        }
+
+        // Leave a single self-contained file behind, in the default journal mode
+        databs.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+        databs.exec("PRAGMA journal_mode = DELETE");
+        std::cerr<<"Wrote "<<options.file<<" in "<<total.seconds()<<"s\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch(const std::exception& e) {
+        std::cerr<<"[ERROR]: "<<e.what()<<"\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (std::filesystem::exists(options.file)) {
+        std::cerr<<"[ERROR]: "<<options.file<<" already exists\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        generate(options);
+    }
+    catch(const SQLite::Exception& e) {
+        std::cerr<<"[ERROR] Database engine error. <"<<e.what()<<">"<<std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}